@@ -13,9 +13,9 @@ namespace ComponentParser_tests {
 
     bool MatchRegexp(const std::string &s, const NFA &nfa) {
         NFA::Set st{nfa.get_start()};
-        st = E_closure(st);
+        st = nfa.E_closure(st);
         for (char c: s) {
-            st = E_closure(Move(st, c));
+            st = nfa.E_closure(nfa.Move(st, c));
         }
         return st.count(nfa.get_end()) != 0;
     }
@@ -138,6 +138,27 @@ namespace ComponentParser_tests {
         EXPECT_TRUE(MatchRegexp("A", res["id"]));
     }
 
+    TEST(BuildingNFAsFromMultipleComponents, RangesShareTwoNodes) {
+        ComponentParser componentParser;
+        std::vector<std::pair<std::string, std::vector<component>>> components = buildBasicComponents();
+        // a-z | A-Z | 0-9 | _
+        components.emplace_back("idChar", std::vector<component>{{RED_DEF, "a"}, {TO, ""}, {RED_DEF, "z"},
+                                                                 {OR, ""},
+                                                                 {RED_DEF, "A"}, {TO, ""}, {RED_DEF, "Z"},
+                                                                 {OR, ""},
+                                                                 {RED_DEF, "0"}, {TO, ""}, {RED_DEF, "9"},
+                                                                 {OR, ""},
+                                                                 {RED_DEF, "_"}});
+        std::unordered_map<std::string, NFA> res = componentParser.regDefinitionsToNFAs(components);
+        EXPECT_EQ(res["idChar"].size(), 2);
+        for (const std::string s : {"a", "m", "z", "A", "Q", "Z", "0", "9", "_"}) {
+            EXPECT_TRUE(MatchRegexp(s, res["idChar"])) << s;
+        }
+        for (const std::string s : {"", "-", "`", "[", "@", ":", "az"}) {
+            EXPECT_FALSE(MatchRegexp(s, res["idChar"])) << s;
+        }
+    }
+
 
     TEST(BuildingNFAsFromMultipleComponents, Exception) {
         ComponentParser componentParser;
@@ -2,13 +2,41 @@
 // Created by hazem on 5/3/2021.
 //
 #include "gtest/gtest.h"
+#include <fstream>
 #include "../src/NFA/NFA_Builder.h"
 #include "../src/Parser/RegularExpression.h"
 #include "../src/DFA/DFA.h"
+#include "../src/DFA/DFA_image.h"
 
 namespace DFA_tests {
     const char DEFAULT_CHAR = 'a';
 
+    // Per-state view of a DFA which is used to describe the expected automata.
+    struct State {
+        explicit State(int id) : id(id), isAcceptingState(false) {
+            transitions.resize(CHAR_MAX + 1);
+        }
+
+        int id;
+        bool isAcceptingState;
+        std::string regEXP;
+        std::vector<int> transitions;
+    };
+
+    std::vector<State> getStates(const DFA &dfa) {
+        std::vector<State> states;
+        for (int i = 0; i < dfa.size(); i++) {
+            State state{i};
+            state.isAcceptingState = dfa.isAcceptingState(i);
+            state.regEXP = dfa.getRegEXP(i);
+            for (int c = 0; c < CHAR_MAX + 1; c++) {
+                state.transitions[c] = dfa.next(i, (char) c);
+            }
+            states.push_back(std::move(state));
+        }
+        return states;
+    }
+
     TEST(DFAConstruction, SingleNFANoMinimize) {
         // a
         // NFA: 0 -a-> 1
@@ -18,13 +46,14 @@ namespace DFA_tests {
         // start state is 0, phi state is 1 and final(accepting) state is 2
         RegularExpression exp(std::string{DEFAULT_CHAR}, 1, NFA{DEFAULT_CHAR});
         DFA dfa({exp});
-        const std::vector<DFA::State> &states = dfa.getStates();
+        const std::vector<State> states = getStates(dfa);
         const int start_state = 0, phi_state = 1, end_state = 2;
         EXPECT_TRUE(states.size() == 3);
         EXPECT_TRUE(!states[start_state].isAcceptingState &&
                     !states[phi_state].isAcceptingState &&
                     states[end_state].isAcceptingState);// check that state 2 is accepting state and state 1, 0 are not.
         EXPECT_TRUE(states[end_state].regEXP == exp.getName());
+        EXPECT_EQ(dfa.getDeadState(), phi_state);
         //  All states point to the phi state under all inputs with the exception of the starting state pointing
         //  to the end state under input DEFAULT_CHAR.
         for (char c = 1; c < CHAR_MAX; ++c) {
@@ -57,7 +86,7 @@ namespace DFA_tests {
         // all states go to phi_state for any input other than the above.
         // state 3 is ending state for 'aa' and 'a*' but its regular expression is aa
         // because it has lower priority i.e earlier in the input file.
-        const std::vector<DFA::State> &states = dfa.getStates();
+        const std::vector<State> states = getStates(dfa);
         constexpr int num_states = 5;
         EXPECT_TRUE(states.size() == num_states);
         std::array<bool, num_states> expected_flag{true, false, true, true, true};
@@ -81,10 +110,10 @@ namespace DFA_tests {
         }
     }
 
-    bool dfs(int nodeA, int nodeB, const std::vector<DFA::State> &a, const std::vector<DFA::State> &b,
-             std::unordered_map<const DFA::State *, const DFA::State *> &visited) {
-        const DFA::State *a_ptr = &a[nodeA];
-        const DFA::State *b_ptr = &b[nodeB];
+    bool dfs(int nodeA, int nodeB, const std::vector<State> &a, const std::vector<State> &b,
+             std::unordered_map<const State *, const State *> &visited) {
+        const State *a_ptr = &a[nodeA];
+        const State *b_ptr = &b[nodeB];
         int is_visited_a = visited.count(a_ptr);
         int is_visited_b = visited.count(b_ptr);
         if(is_visited_a != is_visited_b){
@@ -105,12 +134,12 @@ namespace DFA_tests {
         return ans;
     }
 
-    bool areEqual(const std::vector<DFA::State> &a, const std::vector<DFA::State> &b) {
-        std::unordered_map<const DFA::State *, const DFA::State *> visited;
+    bool areEqual(const std::vector<State> &a, const std::vector<State> &b) {
+        std::unordered_map<const State *, const State *> visited;
         return dfs(0, 0, a, b, visited);
     }
 
-    void set_state_arguments(DFA::State &state, const int id, const bool is_accepting, const std::string &regExp) {
+    void set_state_arguments(State &state, const int id, const bool is_accepting, const std::string &regExp) {
         state.id = id;
         state.isAcceptingState = is_accepting;
         state.regEXP = regExp;
@@ -118,7 +147,7 @@ namespace DFA_tests {
 
     TEST(DFAAreEqualTest, Identity) {
         DFA dfa({{"", 1, NFA{DEFAULT_CHAR}}});
-        EXPECT_TRUE(areEqual(dfa.getStates(), dfa.getStates()));
+        EXPECT_TRUE(areEqual(getStates(dfa), getStates(dfa)));
     }
 
     TEST(DFAAreEqualTest, DifferentProperties) {
@@ -129,9 +158,9 @@ namespace DFA_tests {
         // With each state pointing to state phi (5) for any other input.
         constexpr int num_expected_nodes = 6;
         constexpr int phi_state = 5;
-        DFA::State DEFAULT_STATE = DFA::State{0};
+        State DEFAULT_STATE = State{0};
         std::fill(DEFAULT_STATE.transitions.begin(), DEFAULT_STATE.transitions.end(), phi_state);
-        std::vector<DFA::State> expected(num_expected_nodes, DEFAULT_STATE);
+        std::vector<State> expected(num_expected_nodes, DEFAULT_STATE);
 
         set_state_arguments(expected[0], 0, false, "");
         expected[0].transitions['a'] = 1;
@@ -149,7 +178,7 @@ namespace DFA_tests {
         set_state_arguments(expected[4], 4, true, "default");
 
         // Copy the state diagram and adding a transition from 3 to 4 with a different char.
-        std::vector<DFA::State> actual = expected;
+        std::vector<State> actual = expected;
 
         EXPECT_TRUE(areEqual(actual, expected));
 
@@ -203,9 +232,9 @@ namespace DFA_tests {
         // With each state pointing to state phi (2) for any input other than DEFAULT_CHAR.
         constexpr int num_expected_nodes = 3;
         constexpr int phi_state = 2;
-        DFA::State DEFAULT_STATE = DFA::State{0};
+        State DEFAULT_STATE = State{0};
         std::fill(DEFAULT_STATE.transitions.begin(), DEFAULT_STATE.transitions.end(), phi_state);
-        std::vector<DFA::State> expected(num_expected_nodes, DEFAULT_STATE);
+        std::vector<State> expected(num_expected_nodes, DEFAULT_STATE);
 
         set_state_arguments(expected[0], 0, true, "{aa}*");
         expected[0].transitions[DEFAULT_CHAR] = 1;
@@ -213,7 +242,7 @@ namespace DFA_tests {
         set_state_arguments(expected[1], 1, false, "");
         expected[1].transitions[DEFAULT_CHAR] = 0;
 
-        EXPECT_TRUE(areEqual(dfa.getStates(), expected));
+        EXPECT_TRUE(areEqual(getStates(dfa), expected));
     }
 
     TEST(DFAConstruction, IdentityMinimization) {
@@ -230,9 +259,9 @@ namespace DFA_tests {
         // With each state pointing to state phi (2) for any input other than DEFAULT_CHAR.
         constexpr int num_expected_nodes = 3;
         constexpr int phi_state = 2;
-        DFA::State DEFAULT_STATE = DFA::State{0};
+        State DEFAULT_STATE = State{0};
         std::fill(DEFAULT_STATE.transitions.begin(), DEFAULT_STATE.transitions.end(), phi_state);
-        std::vector<DFA::State> expected(num_expected_nodes, DEFAULT_STATE);
+        std::vector<State> expected(num_expected_nodes, DEFAULT_STATE);
 
         set_state_arguments(expected[0], 0, true, "{aa}*");
         expected[0].transitions[DEFAULT_CHAR] = 1;
@@ -240,7 +269,7 @@ namespace DFA_tests {
         set_state_arguments(expected[1], 1, false, "");
         expected[1].transitions[DEFAULT_CHAR] = 0;
 
-        EXPECT_TRUE(areEqual(dfa.getStates(), expected));
+        EXPECT_TRUE(areEqual(getStates(dfa), expected));
     }
 
     TEST(DFAConstruction, ComplexNFA) {
@@ -258,9 +287,9 @@ namespace DFA_tests {
         // With each state pointing to state phi (3) for any other input.
         constexpr int num_expected_nodes = 4;
         constexpr int phi_state = 3;
-        DFA::State DEFAULT_STATE = DFA::State{0};
+        State DEFAULT_STATE = State{0};
         std::fill(DEFAULT_STATE.transitions.begin(), DEFAULT_STATE.transitions.end(), phi_state);
-        std::vector<DFA::State> expected(num_expected_nodes, DEFAULT_STATE);
+        std::vector<State> expected(num_expected_nodes, DEFAULT_STATE);
 
         set_state_arguments(expected[0], 0, false, "");
         expected[0].transitions['c'] = 1;
@@ -272,7 +301,7 @@ namespace DFA_tests {
         expected[2].transitions['a'] = 2;
         expected[2].transitions['b'] = 2;
 
-        EXPECT_TRUE(areEqual(dfa.getStates(), expected));
+        EXPECT_TRUE(areEqual(getStates(dfa), expected));
     }
 
     TEST(DFAConstruction, ComplexNFA2) {
@@ -290,9 +319,9 @@ namespace DFA_tests {
         // With each state pointing to state phi (3) for any other input.
         constexpr int num_expected_nodes = 3;
         constexpr int phi_state = 2;
-        DFA::State DEFAULT_STATE = DFA::State{0};
+        State DEFAULT_STATE = State{0};
         std::fill(DEFAULT_STATE.transitions.begin(), DEFAULT_STATE.transitions.end(), phi_state);
-        std::vector<DFA::State> expected(num_expected_nodes, DEFAULT_STATE);
+        std::vector<State> expected(num_expected_nodes, DEFAULT_STATE);
 
         set_state_arguments(expected[0], 0, true, "(d* (c |a))*");
         expected[0].transitions['a'] = 0;
@@ -304,6 +333,117 @@ namespace DFA_tests {
         expected[1].transitions['c'] = 0;
         expected[1].transitions['d'] = 1;
 
-        EXPECT_TRUE(areEqual(dfa.getStates(), expected));
+        EXPECT_TRUE(areEqual(getStates(dfa), expected));
+    }
+
+    TEST(DFAConstruction, CharClasses) {
+        // Regular expression: (a | b)* c
+        NFA res = NFA_Builder().Concatenate('a').Or('b').Kleene_closure().Concatenate('c').build();
+        DFA dfa({{"(a | b)* c", 1, res}});
+        // 'a' and 'b' are interchangeable, so the DFA only distinguishes {a, b}, {c} and every other char.
+        EXPECT_EQ(dfa.getClassCount(), 3);
+        EXPECT_EQ(dfa.getTable().columns(), 3);
+        EXPECT_EQ(dfa.column_of('a'), dfa.column_of('b'));
+        EXPECT_NE(dfa.column_of('a'), dfa.column_of('c'));
+        EXPECT_EQ(dfa.column_of(EPSILON), 0);
+        for (int c = 0; c < DFA::BYTE_VALUES; c++) {
+            if (c != 'a' && c != 'b' && c != 'c') {
+                EXPECT_EQ(dfa.column_of(static_cast<char>(c)), 0) << "Failed at char #" << c;
+            }
+        }
+    }
+
+    TEST(DFAMinimization, HopcroftMatchesIterative) {
+        NFA aa_kclosure = NFA_Builder().Concatenate('a').Concatenate('a').Kleene_closure().build();
+        NFA c_or_cb = NFA_Builder().Concatenate('c').Concatenate('b').Concatenate(
+                NFA_Builder().Concatenate('a').Or('b').Kleene_closure().build()).build();
+        NFA nested = NFA_Builder().Concatenate('d').Kleene_closure().Concatenate(
+                NFA_Builder(NFA{'c'}).Or('a').build()).Kleene_closure().build();
+        // (a | b)* a (a | b) (a | b) needs every state of the subset construction.
+        NFA a_or_b = NFA_Builder().Concatenate('a').Or('b').build();
+        NFA third_from_last = NFA_Builder(a_or_b).Kleene_closure().Concatenate('a')
+                .Concatenate(a_or_b).Concatenate(a_or_b).build();
+        std::vector<std::vector<RegularExpression>> regEXPSets{
+                {{"{aa}*", 1, aa_kclosure}},
+                {{"c", 1, NFA{'c'}}, {"cb (a | b)*", 2, c_or_cb}},
+                {{"(d* (c |a))*", 1, nested}},
+                {{"third", 1, third_from_last}, {"{aa}*", 2, aa_kclosure}, {"c", 3, NFA{'c'}}},
+        };
+        for (const auto &regEXPs : regEXPSets) {
+            DFA hopcroft(regEXPs, DFA::Minimization::HOPCROFT);
+            DFA iterative(regEXPs, DFA::Minimization::ITERATIVE);
+            EXPECT_EQ(hopcroft.size(), iterative.size());
+            EXPECT_EQ(hopcroft.getClassCount(), iterative.getClassCount());
+            EXPECT_TRUE(areEqual(getStates(hopcroft), getStates(iterative)));
+        }
+    }
+
+    TEST(TransitionTable, PicksNarrowestCellType) {
+        for (const auto &[rows, expected_size] : std::vector<std::pair<int, int>>{{2,      1},
+                                                                                  {256,    1},
+                                                                                  {257,    2},
+                                                                                  {65536,  2},
+                                                                                  {65537,  4}}) {
+            constexpr int columns = 2;
+            std::vector<int> cells(rows * columns);
+            for (int row = 0; row < rows; row++) {
+                cells[row * columns] = row;
+                cells[row * columns + 1] = rows - row - 1;
+            }
+            Transition_table table(rows, columns, cells);
+            EXPECT_EQ(table.entry_size(), expected_size);
+            EXPECT_EQ(table.rows(), rows);
+            EXPECT_EQ(table.columns(), columns);
+            for (int row = 0; row < rows; row++) {
+                EXPECT_EQ(table.at(row, 0), row);
+                EXPECT_EQ(table.at(row, 1), rows - row - 1);
+            }
+        }
+    }
+
+    TEST(DFAImage, LoadsWrittenImage) {
+        NFA id = NFA_Builder(NFA{'a', 'z'}).Concatenate(
+                NFA_Builder(NFA{'a', 'z'}).Or(NFA{'0', '9'}).Kleene_closure().build()).build();
+        NFA keyword = NFA_Builder(NFA{'i'}).Concatenate('f').build();
+        NFA num = NFA_Builder(NFA{'0', '9'}).Positive_closure().build();
+        DFA dfa({{"if", 1, keyword}, {"id", 2, id}, {"num", 3, num}});
+        const std::string path = ::testing::TempDir() + "dfa_image_test.bin";
+        ASSERT_TRUE(DFA_image::write(path, dfa, 42, true));
+
+        bool grammar_error = false;
+        std::optional<DFA> loaded = DFA_image::load(path, 42, &grammar_error);
+        ASSERT_TRUE(loaded.has_value());
+        EXPECT_TRUE(grammar_error);
+        EXPECT_EQ(loaded->getClassCount(), dfa.getClassCount());
+        EXPECT_EQ(loaded->getCharClasses(), dfa.getCharClasses());
+        EXPECT_EQ(loaded->getAcceptingTokens(), dfa.getAcceptingTokens());
+        EXPECT_EQ(loaded->getTokenNames(), dfa.getTokenNames());
+        EXPECT_EQ(loaded->getTable().entry_size(), dfa.getTable().entry_size());
+        EXPECT_TRUE(areEqual(getStates(*loaded), getStates(dfa)));
+
+        // Images of other rules aren't used.
+        EXPECT_FALSE(DFA_image::load(path, 43, &grammar_error).has_value());
+        std::remove(path.c_str());
+        EXPECT_FALSE(DFA_image::load(path, 42, &grammar_error).has_value());
+    }
+
+    TEST(DFAImage, RejectsTruncatedImage) {
+        DFA dfa({{"ab", 1, NFA_Builder(NFA{'a'}).Concatenate('b').build()}});
+        const std::string path = ::testing::TempDir() + "dfa_image_truncated.bin";
+        ASSERT_TRUE(DFA_image::write(path, dfa, 7, false));
+        std::string content;
+        {
+            std::ifstream file(path, std::ios::in | std::ios::binary);
+            content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        bool grammar_error = false;
+        for (std::size_t size : {std::size_t{0}, std::size_t{10}, content.size() / 2, content.size() - 1}) {
+            {
+                std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+                file.write(content.data(), size);
+            }
+            EXPECT_FALSE(DFA_image::load(path, 7, &grammar_error).has_value()) << "Loaded " << size << " bytes";
+        }
+        std::remove(path.c_str());
     }
 }
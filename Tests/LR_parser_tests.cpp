@@ -0,0 +1,220 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include "../src/Syntax_Parser/LR_parser.h"
+#include "Syntax_tests_helper.h"
+
+namespace LR_parser_tests {
+
+    std::vector<std::string> toStrings(const LALR_table &table, const std::vector<int> &reductions) {
+        std::vector<std::string> ret;
+        for (int production : reductions) {
+            std::string line{table.get_symbol(table.get_lhs(production)).name};
+            line += " ->";
+            for (const int *id = table.get_production_begin(production); id != table.get_production_end(production); id++) {
+                line += " ";
+                line += table.get_symbol(*id).name;
+            }
+            ret.push_back(line);
+        }
+        return ret;
+    }
+
+    // Simulates the parser on the given terminals, returning the reductions or {"error"}.
+    std::vector<std::string> run(const LALR_table &table, const std::vector<std::string> &input) {
+        std::vector<int> states{0}, reductions;
+        std::size_t next = 0;
+        while (true) {
+            const int terminal = table.get_id({next < input.size() ? input[next] : "$", Symbol::Type::TERMINAL});
+            const LALR_table::Action action = terminal < 0 ? LALR_table::ERROR : table.get_action(states.back(), terminal);
+            if (LALR_table::is_shift(action)) {
+                states.push_back(LALR_table::shift_state(action));
+                next++;
+            } else if (LALR_table::is_reduce(action)) {
+                const int production = LALR_table::reduce_production(action);
+                if (production == LALR_table::ACCEPT_PRODUCTION) {
+                    return toStrings(table, reductions);
+                }
+                states.resize(states.size() - table.get_production_length(production));
+                states.push_back(table.get_goto(states.back(), table.get_lhs(production)));
+                reductions.push_back(production);
+            } else {
+                return {"error"};
+            }
+        }
+    }
+
+    TEST(LALRTable, leftRecursion) {
+        //Input :
+        //E  -> E '+' T | T
+        //T  -> T '*' F | F
+        //F  -> '(' E ')' | 'i'
+        std::unordered_map<Symbol, Rule> rules = {
+                {{"E", Symbol::Type::NON_TERMINAL}, writeRule("E", writeProductions({"E '+' T", "T"}))},
+                {{"T", Symbol::Type::NON_TERMINAL}, writeRule("T", writeProductions({"T '*' F", "F"}))},
+                {{"F", Symbol::Type::NON_TERMINAL}, writeRule("F", writeProductions({"'(' E ')'", "'i'"}))}
+        };
+        LALR_table table(rules, {"E", Symbol::Type::NON_TERMINAL});
+        EXPECT_FALSE(table.fail());
+        // 12 LR(0) states of 6 terminals and 4 non terminals.
+        EXPECT_EQ(table.state_count(), 12);
+        EXPECT_LT(table.packed_size(), (std::size_t) table.state_count() * 10);
+
+        std::vector<std::string> expected{
+                "F -> i", "T -> F", "E -> T", "F -> i", "T -> F", "F -> i", "T -> T * F", "E -> E + T"
+        };
+        EXPECT_EQ(run(table, {"i", "+", "i", "*", "i"}), expected);
+        expected = {"F -> i", "T -> F", "E -> T", "F -> ( E )", "T -> F", "E -> T"};
+        EXPECT_EQ(run(table, {"(", "i", ")"}), expected);
+        EXPECT_EQ(run(table, {"i", "+"}), std::vector<std::string>{"error"});
+        EXPECT_EQ(run(table, {"i", "i"}), std::vector<std::string>{"error"});
+    }
+
+    TEST(LALRTable, notSLR) {
+        //Input :
+        //S  -> L '=' R | R
+        //L  -> '*' R | 'id'
+        //R  -> L
+        // FOLLOW(R) has '=', so SLR tables have a conflict on '=' after L, which the LALR(1) lookaheads avoid.
+        std::unordered_map<Symbol, Rule> rules = {
+                {{"S", Symbol::Type::NON_TERMINAL}, writeRule("S", writeProductions({"L '=' R", "R"}))},
+                {{"L", Symbol::Type::NON_TERMINAL}, writeRule("L", writeProductions({"'*' R", "'id'"}))},
+                {{"R", Symbol::Type::NON_TERMINAL}, writeRule("R", writeProductions({"L"}))}
+        };
+        LALR_table table(rules, {"S", Symbol::Type::NON_TERMINAL});
+        EXPECT_FALSE(table.fail());
+        std::vector<std::string> expected{"L -> id", "L -> id", "R -> L", "L -> * R", "R -> L", "S -> L = R"};
+        EXPECT_EQ(run(table, {"id", "=", "*", "id"}), expected);
+    }
+
+    TEST(LALRTable, epsilonAndConflicts) {
+        //Input :
+        //S  -> A 'x' | 'y'
+        //A  -> A 'a' | #
+        std::unordered_map<Symbol, Rule> rules = {
+                {{"S", Symbol::Type::NON_TERMINAL}, writeRule("S", writeProductions({"A 'x'", "'y'"}))},
+                {{"A", Symbol::Type::NON_TERMINAL}, writeRule("A", writeProductions({"A 'a'", "#"}))}
+        };
+        LALR_table table(rules, {"S", Symbol::Type::NON_TERMINAL});
+        EXPECT_FALSE(table.fail());
+        std::vector<std::string> expected{"A ->", "A -> A a", "A -> A a", "S -> A x"};
+        EXPECT_EQ(run(table, {"a", "a", "x"}), expected);
+        EXPECT_EQ(run(table, {"y"}), std::vector<std::string>{"S -> y"});
+
+        //E  -> E '+' E | 'i' is ambiguous.
+        std::unordered_map<Symbol, Rule> ambiguous = {
+                {{"E", Symbol::Type::NON_TERMINAL}, writeRule("E", writeProductions({"E '+' E", "'i'"}))}
+        };
+        EXPECT_TRUE(LALR_table(ambiguous, {"E", Symbol::Type::NON_TERMINAL}).fail());
+    }
+
+    class LRParserTest : public ::testing::Test {
+    protected:
+        std::string tempProgramPath{::testing::TempDir() + "tempLRProgram.txt"};
+
+        // The left recursive grammar which the LL(1) parser needs to be rewritten first.
+        std::unordered_map<Symbol, Rule> rules = {
+                {{"METHOD_BODY", Symbol::Type::NON_TERMINAL},
+                        writeRule("METHOD_BODY", writeProductions({"STATEMENT_LIST"}))},
+                {{"STATEMENT_LIST", Symbol::Type::NON_TERMINAL},
+                        writeRule("STATEMENT_LIST", writeProductions({"STATEMENT", "STATEMENT_LIST STATEMENT"}))},
+                {{"STATEMENT", Symbol::Type::NON_TERMINAL},
+                        writeRule("STATEMENT", writeProductions({"DECLARATION", "ASSIGNMENT"}))},
+                {{"DECLARATION", Symbol::Type::NON_TERMINAL},
+                        writeRule("DECLARATION", writeProductions({"PRIMITIVE_TYPE 'id' ';'"}))},
+                {{"PRIMITIVE_TYPE", Symbol::Type::NON_TERMINAL},
+                        writeRule("PRIMITIVE_TYPE", writeProductions({"'int'", "'float'"}))},
+                {{"ASSIGNMENT", Symbol::Type::NON_TERMINAL},
+                        writeRule("ASSIGNMENT", writeProductions({"'id' 'assign' EXPRESSION ';'"}))},
+                {{"EXPRESSION", Symbol::Type::NON_TERMINAL},
+                        writeRule("EXPRESSION", writeProductions({"EXPRESSION 'addop' TERM", "TERM"}))},
+                {{"TERM", Symbol::Type::NON_TERMINAL}, writeRule("TERM", writeProductions({"'id'", "'num'"}))}
+        };
+
+        void writeProgram(const std::string &program) {
+            std::ofstream file{tempProgramPath};
+            file << program;
+        }
+
+        void TearDown() override {
+            std::remove(tempProgramPath.c_str());
+        }
+    };
+
+    TEST_F(LRParserTest, Statements) {
+        LexicalParser lexicalParser(LAB_INPUT_PATH);
+        ASSERT_FALSE(lexicalParser.has_grammar_error());
+        writeProgram("int x;\nx = 5 + y;\n");
+        lexicalParser.set_input_stream(tempProgramPath);
+
+        LR_parser parser(rules, {"METHOD_BODY", Symbol::Type::NON_TERMINAL});
+        EXPECT_FALSE(parser.fail());
+        auto [reductions, status] = parser.parse(lexicalParser);
+        EXPECT_TRUE(status == LR_parser::Status::ACCEPTED);
+        std::vector<std::string> expected{
+                "PRIMITIVE_TYPE -> int",
+                "DECLARATION -> PRIMITIVE_TYPE id ;",
+                "STATEMENT -> DECLARATION",
+                "STATEMENT_LIST -> STATEMENT",
+                "TERM -> num",
+                "EXPRESSION -> TERM",
+                "TERM -> id",
+                "EXPRESSION -> EXPRESSION addop TERM",
+                "ASSIGNMENT -> id assign EXPRESSION ;",
+                "STATEMENT -> ASSIGNMENT",
+                "STATEMENT_LIST -> STATEMENT_LIST STATEMENT",
+                "METHOD_BODY -> STATEMENT_LIST",
+        };
+        EXPECT_EQ(toStrings(parser.get_table(), reductions), expected);
+    }
+
+    TEST_F(LRParserTest, Recovery) {
+        LexicalParser lexicalParser(LAB_INPUT_PATH);
+        ASSERT_FALSE(lexicalParser.has_grammar_error());
+        // The states are popped back to the one after 'int', which shifts the second x, then the tokens up to ;
+        // are discarded.
+        writeProgram("int x x = 1;\n");
+        lexicalParser.set_input_stream(tempProgramPath);
+
+        LR_parser parser(rules, {"METHOD_BODY", Symbol::Type::NON_TERMINAL});
+        auto [reductions, status] = parser.parse(lexicalParser);
+        EXPECT_TRUE(status == LR_parser::Status::ACCEPTED_WITH_ERRORS);
+        std::vector<std::string> expected{
+                "PRIMITIVE_TYPE -> int",
+                "DECLARATION -> PRIMITIVE_TYPE id ;",
+                "STATEMENT -> DECLARATION",
+                "STATEMENT_LIST -> STATEMENT",
+                "METHOD_BODY -> STATEMENT_LIST",
+        };
+        EXPECT_EQ(toStrings(parser.get_table(), reductions), expected);
+
+        writeProgram("int x");
+        lexicalParser.set_input_stream(tempProgramPath);
+        EXPECT_TRUE(parser.parse(lexicalParser).second == LR_parser::Status::NOT_MATCHED);
+    }
+
+    TEST_F(LRParserTest, TokenNotInGrammar) {
+        LexicalParser lexicalParser(LAB_INPUT_PATH);
+        ASSERT_FALSE(lexicalParser.has_grammar_error());
+        // relop is a token of the lexical rules but not a terminal of the grammar, so it's discarded.
+        writeProgram("int x;\nint y > ;\nint z;\n");
+        lexicalParser.set_input_stream(tempProgramPath);
+
+        LR_parser parser(rules, {"METHOD_BODY", Symbol::Type::NON_TERMINAL});
+        testing::internal::CaptureStderr();
+        auto [reductions, status] = parser.parse(lexicalParser);
+        EXPECT_EQ(testing::internal::GetCapturedStderr(),
+                  "Error in line 2, column 7: (unexpected relop) - discard \">\".\n");
+        EXPECT_TRUE(status == LR_parser::Status::ACCEPTED_WITH_ERRORS);
+        const std::vector<std::string> declaration{
+                "PRIMITIVE_TYPE -> int", "DECLARATION -> PRIMITIVE_TYPE id ;", "STATEMENT -> DECLARATION"};
+        std::vector<std::string> expected{declaration};
+        expected.emplace_back("STATEMENT_LIST -> STATEMENT");
+        for (int i = 0; i < 2; i++) {
+            expected.insert(expected.end(), declaration.begin(), declaration.end());
+            expected.emplace_back("STATEMENT_LIST -> STATEMENT_LIST STATEMENT");
+        }
+        expected.emplace_back("METHOD_BODY -> STATEMENT_LIST");
+        EXPECT_EQ(toStrings(parser.get_table(), reductions), expected);
+    }
+}
@@ -36,6 +36,48 @@ namespace Parser_tests {
             tempProgramFile.flush();
         }
 
+        // Rules of the random programs below.
+        void writeNumberRules() {
+            writeRules("letter = a-z", "digit = 0-9", "digits = digit+", "id : letter (letter | digit)*",
+                       "num : digit+ | digit+ . digits ( \\L | E digits)", "addop : \\+", "[; ( )]");
+        }
+
+        /**
+         * Random program of at least size bytes, with a run of up to maxRun x one time in runOdds, an unmatched #
+         * one time in errorOdds, and newlines or only spaces between tokens.
+         */
+        static std::string randomProgram(std::mt19937 &random, std::size_t size, std::size_t maxRun, int runOdds,
+                                         int errorOdds, bool newlines) {
+            std::string program;
+            while (program.size() < size) {
+                switch (random() % 8) {
+                    case 0:
+                        if (random() % runOdds == 0) {
+                            program += std::string(random() % maxRun, 'x');
+                        }
+                        break;
+                    case 1: program += "12.5E" + std::to_string(random()); break;
+                    case 2: program += "12.5E+"; break;
+                    case 3: program += random() % errorOdds == 0 ? "#" : ""; break;
+                    case 4: program += std::string(random() % 3, ' ') + (newlines ? "\n" : " "); break;
+                    case 5: program += "(ab1+" + std::to_string(random()) + ");"; break;
+                    default: program += std::string(1 + random() % 4, "abc1"[random() % 4]); break;
+                }
+            }
+            return program;
+        }
+
+        // Kinds and lexemes of all the remaining tokens.
+        static std::vector<std::pair<int, std::string>> scanAll(LexicalParser &lexicalParser) {
+            std::vector<std::pair<int, std::string>> tokens;
+            Compact_token token{};
+            while (lexicalParser.get_token(token)) {
+                tokens.emplace_back(token.kind, std::string(token.lexeme));
+                lexicalParser.next_token();
+            }
+            return tokens;
+        }
+
         void TearDown() override {
             if (tempRulesFile.is_open()) {
                 tempRulesFile.close();
@@ -219,4 +261,333 @@ namespace Parser_tests {
         }
     }
 
+    TEST_F(LexicalParserTest, SkipsBlankLinesAndWhitespace) {
+        writeRules("letter = a-z", "id : letter+", "[;]");
+        writeProgram("ab;", "", "  \t", "\tcd\r", "\f#\v", "ef ;");
+
+        LexicalParser lexicalParser(tempRulesPath);
+        lexicalParser.set_input_stream(tempProgramPath);
+
+        std::vector<Token> expectedTokens{
+                {"id", "ab"},
+                {";",  ";"},
+                {"id", "cd"},
+                {"id", "ef"},
+                {";",  ";"}};
+
+        for (const auto &expected : expectedTokens) {
+            Token token;
+            ASSERT_TRUE(lexicalParser.get_token(token));
+            lexicalParser.next_token();
+            EXPECT_EQ(token.regEXP, expected.regEXP);
+            EXPECT_EQ(token.match_string, expected.match_string);
+        }
+        Token token;
+        EXPECT_FALSE(lexicalParser.get_token(token));
+    }
+
+    TEST_F(LexicalParserTest, CompactTokens) {
+        writeRules("letter = a-z", "digit = 0-9", "id : letter+", "num : digit+", "[;]");
+        writeProgram("abc 12;", "x");
+
+        LexicalParser lexicalParser(tempRulesPath);
+        lexicalParser.set_input_stream(tempProgramPath);
+        const std::vector<std::string> &names = lexicalParser.get_token_names();
+
+        std::vector<Token> expectedTokens{
+                {"id",  "abc"},
+                {"num", "12"},
+                {";",   ";"},
+                {"id",  "x"}};
+        const char *previous_end = nullptr;
+        for (const auto &expected : expectedTokens) {
+            Compact_token token{};
+            ASSERT_TRUE(lexicalParser.get_token(token));
+            lexicalParser.next_token();
+            EXPECT_EQ(names[token.kind], expected.regEXP);
+            EXPECT_EQ(token.lexeme, expected.match_string);
+            // Lexemes point into the same input buffer.
+            if (previous_end != nullptr) {
+                EXPECT_LE(previous_end, token.lexeme.data());
+            }
+            previous_end = token.lexeme.data() + token.lexeme.size();
+        }
+        Compact_token token{};
+        EXPECT_FALSE(lexicalParser.get_token(token));
+    }
+
+    TEST_F(LexicalParserTest, LongSingleLineIsLinear) {
+        writeRules("letter = a-z", "id : letter+", "assign : \\=", "addop : \\+", "mulop : \\*");
+        // A single 4 MB word, scanning to its end for every token would take hours.
+        const std::string pattern = "ab=cd+ef*";
+        const int repetitions = (4 << 20) / (int) pattern.size();
+        std::string line;
+        line.reserve(pattern.size() * repetitions);
+        for (int i = 0; i < repetitions; i++) {
+            line += pattern;
+        }
+        writeProgram(line);
+
+        LexicalParser lexicalParser(tempRulesPath);
+        ASSERT_FALSE(lexicalParser.has_grammar_error());
+        lexicalParser.set_input_stream(tempProgramPath);
+        const std::vector<std::string> &names = lexicalParser.get_token_names();
+        const std::vector<std::string> expected{"id", "assign", "id", "addop", "id", "mulop"};
+        int count = 0;
+        Compact_token token{};
+        while (lexicalParser.get_token(token)) {
+            ASSERT_EQ(names[token.kind], expected[count % expected.size()]);
+            lexicalParser.next_token();
+            count++;
+        }
+        EXPECT_EQ(count, repetitions * (int) expected.size());
+    }
+
+    TEST_F(LexicalParserTest, StreamingMatchesMappedInput) {
+        writeNumberRules();
+        // Tokens of every size, some longer than a chunk, placed so that many of them span chunk boundaries.
+        std::mt19937 random(2021);
+        const std::string program = randomProgram(random, 4 * LexicalParser::CHUNK_SIZE,
+                                                  2 * LexicalParser::CHUNK_SIZE, 8, 1, true);
+        writeProgram(program);
+
+        LexicalParser mapped(tempRulesPath);
+        mapped.set_input_stream(tempProgramPath);
+        const std::vector<std::pair<int, std::string>> expected = scanAll(mapped);
+        EXPECT_GT(expected.size(), 100);
+
+        LexicalParser streamed(tempRulesPath);
+        std::ifstream file(tempProgramPath);
+        streamed.set_input_stream(file);
+        EXPECT_EQ(scanAll(streamed), expected);
+
+        std::istringstream in(program);
+        streamed.set_input_stream(in);
+        EXPECT_EQ(scanAll(streamed), expected);
+    }
+
+    TEST_F(LexicalParserTest, StreamingDropsWhitespaces) {
+        writeRules("letter = a-z", "id : letter+");
+        // The first token stays buffered while the whitespaces after it are skipped to scan the rest of the batch.
+        const std::string spaces(32 * LexicalParser::CHUNK_SIZE, ' ');
+        const std::string newlines(32 * LexicalParser::CHUNK_SIZE, '\n');
+        const std::string program = "ab" + spaces + "cd" + newlines + "ef" + spaces;
+
+        LexicalParser lexicalParser(tempRulesPath);
+        std::istringstream in(program);
+        lexicalParser.set_input_stream(in);
+        Compact_token token{};
+        for (const std::string lexeme : {"ab", "cd", "ef"}) {
+            ASSERT_TRUE(lexicalParser.get_token(token));
+            EXPECT_EQ(token.lexeme, lexeme);
+            EXPECT_EQ(program.compare(token.offset, token.lexeme.size(), token.lexeme), 0);
+            lexicalParser.next_token();
+        }
+        EXPECT_FALSE(lexicalParser.get_token(token));
+        EXPECT_LE(lexicalParser.stream_buffer_size(), 2 * LexicalParser::CHUNK_SIZE + 16);
+    }
+
+    TEST_F(LexicalParserTest, ParallelMatchesSequential) {
+        writeNumberRules();
+        LexicalParser lexicalParser(tempRulesPath);
+        std::mt19937 random(2021);
+        // Programs with and without newlines, the later being split only by the speculative scan.
+        for (bool newlines : {true, false}) {
+            writeProgram(randomProgram(random, 16 * LexicalParser::MIN_PARALLEL_CHUNK, 64, 1, 64, newlines));
+
+            testing::internal::CaptureStderr();
+            lexicalParser.set_input_stream(tempProgramPath);
+            const std::vector<std::pair<int, std::string>> expected = scanAll(lexicalParser);
+            const std::string expectedErrors = testing::internal::GetCapturedStderr();
+            EXPECT_NE(expectedErrors.find("Error in line"), std::string::npos);
+
+            for (auto split : {LexicalParser::Split::LINES, LexicalParser::Split::SPECULATIVE}) {
+                for (unsigned threads : {1, 2, 3, 8}) {
+                    testing::internal::CaptureStderr();
+                    lexicalParser.set_input_stream(tempProgramPath, threads, split);
+                    EXPECT_EQ(scanAll(lexicalParser), expected) << threads;
+                    EXPECT_EQ(testing::internal::GetCapturedStderr(), expectedErrors) << threads;
+                }
+            }
+        }
+    }
+
+    TEST_F(LexicalParserTest, Locations) {
+        writeRules("letter = a-z", "id : letter+", "[;]");
+        std::string program = "ab;\n  cd\r\n\n\tef ;";
+        // Lines long enough for tokens to be located across streamed chunks and parallel chunks.
+        for (int line = 0; program.size() < 4 * LexicalParser::MIN_PARALLEL_CHUNK; line++) {
+            program += "\n" + std::string(line % 7, ' ') + std::string(1 + line % 300, 'x') + "; y";
+        }
+        writeProgram(program);
+
+        auto check = [&](LexicalParser &lexicalParser) {
+            Compact_token token{};
+            std::size_t count = 0;
+            while (lexicalParser.get_token(token)) {
+                ASSERT_EQ(program.compare(token.offset, token.lexeme.size(), token.lexeme), 0);
+                // rfind returns npos on the first line, which wraps around to 0.
+                const std::size_t lineStart = token.offset == 0 ? 0 : program.rfind('\n', token.offset - 1) + 1;
+                const Source_location location = lexicalParser.get_location(token.offset);
+                ASSERT_EQ(location.line, std::count(program.begin(), program.begin() + lineStart, '\n') + 1);
+                ASSERT_EQ(location.column, token.offset - lineStart + 1);
+                lexicalParser.next_token();
+                count++;
+            }
+            EXPECT_GT(count, 1000);
+        };
+        LexicalParser lexicalParser(tempRulesPath);
+        lexicalParser.set_input_stream(tempProgramPath);
+        Compact_token token{};
+        for (auto [line, column] : {std::pair{1, 1}, {1, 3}, {2, 3}, {4, 2}, {4, 5}}) {
+            ASSERT_TRUE(lexicalParser.get_token(token));
+            EXPECT_EQ(lexicalParser.get_location(token.offset).line, line) << token.lexeme;
+            EXPECT_EQ(lexicalParser.get_location(token.offset).column, column) << token.lexeme;
+            lexicalParser.next_token();
+        }
+
+        lexicalParser.set_input_stream(tempProgramPath);
+        check(lexicalParser);
+        std::istringstream in(program);
+        lexicalParser.set_input_stream(in);
+        check(lexicalParser);
+        lexicalParser.set_input_stream(tempProgramPath, 4, LexicalParser::Split::SPECULATIVE);
+        check(lexicalParser);
+    }
+
+    TEST(RingBuffer, WrapsAround) {
+        Ring_buffer<int, 4> ring;
+        EXPECT_TRUE(ring.empty());
+        for (int i = 0; i < 10; i++) {
+            ring.push_back(i);
+            if (ring.full()) {
+                EXPECT_EQ(ring.front(), i - 3);
+                EXPECT_EQ(ring[3], i);
+                ring.pop_front();
+            }
+        }
+        EXPECT_EQ(ring.size(), 3);
+        EXPECT_EQ(ring[0], 7);
+        EXPECT_EQ(ring[2], 9);
+    }
+
+    TEST(SimdScan, SkipRunMatchesScalar) {
+        ByteRanges idChars;
+        std::bitset<256> bytes;
+        for (int c = 0; c < 256; c++) {
+            bytes[c] = std::isalnum(c) || c >= 0xF0;
+        }
+        ASSERT_TRUE(SimdScan::to_ranges(bytes, idChars));
+        EXPECT_EQ(idChars.count, 4);
+        bytes['_'] = true;
+        ByteRanges tooMany;
+        EXPECT_FALSE(SimdScan::to_ranges(bytes, tooMany));
+        EXPECT_EQ(tooMany.count, 0);
+
+        std::mt19937 random(2021);
+        for (const ByteRanges &ranges : {idChars, SimdScan::SPACES}) {
+            for (int run = 0; run < 200; run++) {
+                // Runs of every length ending on a random byte.
+                std::string s;
+                const int length = random() % 100;
+                while ((int) s.size() < length) {
+                    const auto c = static_cast<unsigned char>(random());
+                    if (ranges.contains(c)) {
+                        s.push_back(static_cast<char>(c));
+                    }
+                }
+                s.push_back(static_cast<char>(random()));
+                const std::size_t runEnd = ranges.contains(s.back()) ? s.size() : s.size() - 1;
+                for (auto isa : {SimdScan::Isa::SCALAR, SimdScan::Isa::SSE2, SimdScan::Isa::AVX2}) {
+                    if (SimdScan::supports(isa)) {
+                        for (std::size_t begin = 0; begin <= s.size(); begin += 7) {
+                            EXPECT_EQ(SimdScan::skip_run(s.data() + begin, s.data() + s.size(), ranges, isa) - s.data(),
+                                      std::max(begin, runEnd));
+                        }
+                    }
+                }
+            }
+        }
+        int newlines = 0;
+        const std::string spaces = " \n\t\n\r\v\f                              \n  x\n";
+        EXPECT_EQ(*SimdScan::skip_spaces(spaces.data(), spaces.data() + spaces.size(), newlines), 'x');
+        EXPECT_EQ(newlines, 3);
+    }
+
+    TEST_F(LexicalParserTest, FillAndPeek) {
+        writeRules("letter = a-z", "digit = 0-9", "id : letter+", "num : digit+");
+        // Newlines are added between some tokens so that a full ring spans more than a chunk of the stream.
+        const std::size_t tokenCount = 3 * LexicalParser::TOKEN_RING_CAPACITY;
+        std::string program;
+        for (std::size_t i = 0; i < tokenCount; i++) {
+            program += (i % 2 ? "abcdefg" : "1234567");
+            program += (i % 64 == 63 ? std::string(LexicalParser::CHUNK_SIZE / 8, '\n') : " ");
+        }
+        writeProgram(program);
+
+        auto check = [&](LexicalParser &lexicalParser) {
+            Compact_token token{};
+            EXPECT_TRUE(lexicalParser.peek(2, token));
+            EXPECT_EQ(token.lexeme, "1234567");
+            EXPECT_FALSE(lexicalParser.peek(LexicalParser::TOKEN_RING_CAPACITY, token));
+            std::size_t scanned = 0;
+            while (std::size_t buffered = lexicalParser.fill(LexicalParser::TOKEN_RING_CAPACITY + 1)) {
+                EXPECT_EQ(buffered, std::min(LexicalParser::TOKEN_RING_CAPACITY, tokenCount - scanned));
+                // Buffered lexemes stay valid while the rest of the batch is read.
+                for (std::size_t k = 0; k < buffered; k++, scanned++) {
+                    ASSERT_TRUE(lexicalParser.peek(k, token));
+                    EXPECT_EQ(token.lexeme, scanned % 2 ? "abcdefg" : "1234567");
+                    EXPECT_EQ(lexicalParser.get_token_names()[token.kind], scanned % 2 ? "id" : "num");
+                }
+                // Only half of them are consumed, the rest are peeked again after the next fill.
+                const std::size_t consumed = (buffered + 1) / 2;
+                for (std::size_t k = 0; k < consumed; k++) {
+                    lexicalParser.next_token();
+                }
+                scanned -= buffered - consumed;
+            }
+            EXPECT_EQ(scanned, tokenCount);
+            EXPECT_FALSE(lexicalParser.get_token(token));
+        };
+        LexicalParser mapped(tempRulesPath);
+        mapped.set_input_stream(tempProgramPath);
+        check(mapped);
+
+        LexicalParser streamed(tempRulesPath);
+        std::istringstream in(program);
+        streamed.set_input_stream(in);
+        check(streamed);
+    }
+
+    TEST_F(LexicalParserTest, DFAImage) {
+        writeRules("letter = a-z | A-Z", "digit = 0-9", "id : letter (letter | digit)*", "{if else}", "[; ( )]");
+        writeProgram("if (x1) y; else z");
+        const std::string imagePath = ::testing::TempDir() + "tempRules.dfa";
+        std::remove(imagePath.c_str());
+        std::vector<Token> expectedTokens{
+                {"if",   "if"},
+                {"(",    "("},
+                {"id",   "x1"},
+                {")",    ")"},
+                {"id",   "y"},
+                {";",    ";"},
+                {"else", "else"},
+                {"id",   "z"}};
+        // The first parser writes the image, the second one loads it.
+        for (int run = 0; run < 2; run++) {
+            LexicalParser lexicalParser(tempRulesPath, imagePath);
+            EXPECT_FALSE(lexicalParser.has_grammar_error());
+            lexicalParser.set_input_stream(tempProgramPath);
+            for (const auto &expected : expectedTokens) {
+                Token token;
+                ASSERT_TRUE(lexicalParser.get_token(token));
+                lexicalParser.next_token();
+                EXPECT_EQ(token.regEXP, expected.regEXP);
+                EXPECT_EQ(token.match_string, expected.match_string);
+            }
+            EXPECT_TRUE(std::ifstream(imagePath).is_open());
+        }
+        std::remove(imagePath.c_str());
+    }
+
 }
\ No newline at end of file
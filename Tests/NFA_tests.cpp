@@ -14,27 +14,29 @@ namespace NFA_test {
      * a transition to the corresponding node in the other graph by trying out all of
      * the permutation. For our case, two NFAs are equal if they behave the same.
      */
-    bool dfs(NFA::Set a, NFA::Set b, std::unordered_map<NFA::Set, NFA::Set> &visited) {
-        const int is_visited_a = visited.count(a);
-        const int is_visited_b = visited.count(b);
+    bool dfs(const NFA &nfa_a, const NFA &nfa_b, NFA::Set a, NFA::Set b,
+             std::unordered_map<NFA::Set, NFA::Set> &visited_a, std::unordered_map<NFA::Set, NFA::Set> &visited_b) {
+        const int is_visited_a = visited_a.count(a);
+        const int is_visited_b = visited_b.count(b);
         if(is_visited_a != is_visited_b){
             return false;
         }
         if (is_visited_a) {
-            return visited[a] == b;
+            return visited_a[a] == b;
         }
-        visited[a] = b;
-        visited[b] = a;
+        visited_a[a] = b;
+        visited_b[b] = a;
         bool ans = true;
         for (char c = 0; c < CHAR_MAX && ans; c++) {
-            ans = ans && dfs(Move(a, c), Move(b, c), visited);
+            ans = ans && dfs(nfa_a, nfa_b, nfa_a.Move(a, c), nfa_b.Move(b, c), visited_a, visited_b);
         }
         return ans;
     }
 
     bool areEqual(const NFA &a, const NFA &b) {
-        std::unordered_map<NFA::Set, NFA::Set> visited;
-        return dfs(NFA::Set{a.get_start()}, NFA::Set{b.get_start()}, visited);
+        // Sets of different NFAs hold ids of different nodes, so each NFA has its own visited map.
+        std::unordered_map<NFA::Set, NFA::Set> visited_a, visited_b;
+        return dfs(a, b, NFA::Set{a.get_start()}, NFA::Set{b.get_start()}, visited_a, visited_b);
     }
 
     TEST(NFAAreEqualTest, Identity) {
@@ -50,99 +52,107 @@ namespace NFA_test {
 
     TEST(NFA_test, SingleChar) {
         NFA nfa('a');
-        std::vector<std::unique_ptr<NFA::Node>> nodes;
-        nodes.emplace_back(std::make_unique<NFA::Node>());
-        auto start = nodes.back().get();
-        nodes.emplace_back(std::make_unique<NFA::Node>());
-        auto end = nodes.back().get();
-        start->addTransition('a', end);
-
-        NFA temp{start, end, std::move(nodes)};
+        NFA temp(2, 0, 1);
+        temp.addTransition(0, 'a', 1);
+
         EXPECT_TRUE(areEqual(nfa, temp));
     }
 
     TEST(NFA_test, NFACopy) {
-        std::vector<std::unique_ptr<NFA::Node>> nodes;
-        for (int i = 0; i < 1000; i++) {
-            nodes.emplace_back(std::make_unique<NFA::Node>());
-        }
+        const int node_count = 1000;
+        NFA temp(node_count, 0, node_count - 1);
         char c = 'a';
-        for (int i = 0; i < nodes.size(); i++) {
-            for (int j = 0; j < nodes.size(); j++) {
-                nodes[i]->addTransition(c, nodes[j].get());
+        for (int i = 0; i < node_count; i++) {
+            for (int j = 0; j < node_count; j++) {
+                temp.addTransition(i, c, j);
             }
         }
 
-        auto start = nodes[0].get(), end = nodes.back().get();
-        NFA temp{start, end, std::move(nodes)};
         NFA cpy{temp};
         EXPECT_TRUE(areEqual(temp, cpy));
     }
 
+    TEST(NFA_test, ModifyingCopyKeepsOriginal) {
+        NFA a('a');
+        NFA ab = NFA_Builder(a).Concatenate('b').build();
+        NFA a_or_a = NFA_Builder(a).Or(a).build();
+        EXPECT_TRUE(areEqual(a, NFA{'a'}));
+        EXPECT_TRUE(areEqual(ab, NFA_Builder(NFA{'a'}).Concatenate('b').build()));
+        EXPECT_TRUE(areEqual(a_or_a, NFA_Builder(NFA{'a'}).Or('a').build()));
+    }
+
     TEST(NFA_test, Concatenate) {
         NFA res = NFA_Builder(NFA{'a'}).Concatenate('b').build();
         // res = * a * e * b *
-        std::vector<std::unique_ptr<NFA::Node>> nodes(4);
-        for (auto &arrNode : nodes) {
-            arrNode = std::make_unique<NFA::Node>();
-        }
+        NFA temp(4, 0, 3);
 
         std::vector<char> transitions{'a', EPSILON, 'b'};
-        for (int i = 0; i < nodes.size() - 1; i++) {
-            nodes[i]->addTransition(transitions[i], nodes[i + 1].get());
+        for (int i = 0; i < transitions.size(); i++) {
+            temp.addTransition(i, transitions[i], i + 1);
         }
-        auto start = nodes[0].get(), end = nodes.back().get();
-        NFA temp{start, end, std::move(nodes)};
         EXPECT_TRUE(areEqual(temp, res));
     }
 
     TEST(NFA_test, Or) {
-        NFA res = NFA_Builder(NFA{'a'}).Or('b').build();
+        NFA res = NFA_Builder(NFA{'a'}).Or(NFA{}).build();
         /*    e * a * e
          *  *           *
-         *    e * b * e
+         *    e * e * e
          */
-        std::vector<std::unique_ptr<NFA::Node>> nodes(6);
-        for (auto &arrNode : nodes) {
-            arrNode = std::make_unique<NFA::Node>();
-        }
+        NFA temp(6, 0, 5);
         /*    e 1 a 2 e
          *  0           5
-         *    e 3 b 4 e
+         *    e 3 e 4 e
+         */
+        temp.addTransition(0, EPSILON, 1);
+        temp.addTransition(0, EPSILON, 3);
+        temp.addTransition(1, 'a', 2);
+        temp.addTransition(2, EPSILON, 5);
+        temp.addTransition(3, EPSILON, 4);
+        temp.addTransition(4, EPSILON, 5);
+        EXPECT_TRUE(areEqual(temp, res));
+    }
+
+    TEST(NFA_test, OrOfCharClasses) {
+        NFA res = NFA_Builder(NFA{'a'}).Or('b').Or(NFA{'0', '9'}).build();
+        /*      a
+         *  0 --b-- 1
+         *     0-9
          */
-        nodes[0]->addTransition(EPSILON, nodes[1].get());
-        nodes[0]->addTransition(EPSILON, nodes[3].get());
-        nodes[1]->addTransition('a', nodes[2].get());
-        nodes[2]->addTransition(EPSILON, nodes[5].get());
-        nodes[3]->addTransition('b', nodes[4].get());
-        nodes[4]->addTransition(EPSILON, nodes[5].get());
-
-        auto start = nodes[0].get(), end = nodes.back().get();
-        NFA temp(start, end, std::move(nodes));
+        NFA temp(2, 0, 1);
+        temp.addTransition(0, 'a', 1);
+        temp.addTransition(0, 'b', 1);
+        temp.addTransition(0, '0', '9', 1);
+        EXPECT_EQ(res.size(), 2);
         EXPECT_TRUE(areEqual(temp, res));
     }
 
+    TEST(NFA_test, RangeEdge) {
+        NFA range('c', 'x');
+        EXPECT_EQ(range.size(), 2);
+        EXPECT_EQ(range.Move({range.get_start()}, 'c'), NFA::Set{range.get_end()});
+        EXPECT_EQ(range.Move({range.get_start()}, 'm'), NFA::Set{range.get_end()});
+        EXPECT_EQ(range.Move({range.get_start()}, 'x'), NFA::Set{range.get_end()});
+        EXPECT_TRUE(range.Move({range.get_start()}, 'b').empty());
+        EXPECT_TRUE(range.Move({range.get_start()}, 'y').empty());
+        EXPECT_TRUE(range.Move({range.get_start()}, EPSILON).empty());
+    }
+
     TEST(NFA_test, Positive_closure) {
         NFA res = NFA_Builder(NFA{'a'}).Positive_closure().build();
         /*        e
          *      /   \
          *  * e * a * e *
          */
-        std::vector<std::unique_ptr<NFA::Node>> nodes(4);
-        for (auto &arrNode : nodes) {
-            arrNode = std::make_unique<NFA::Node>();
-        }
+        NFA temp(4, 0, 3);
         /*        e
          *      /   \
          *  0 e 1 a 2 e 3
          */
-        nodes[0]->addTransition(EPSILON, nodes[1].get());
-        nodes[1]->addTransition('a', nodes[2].get());
-        nodes[2]->addTransition(EPSILON, nodes[3].get());
-        nodes[2]->addTransition(EPSILON, nodes[1].get());
-
-        auto start = nodes[0].get(), end = nodes.back().get();
-        NFA temp{start, end, std::move(nodes)};
+        temp.addTransition(0, EPSILON, 1);
+        temp.addTransition(1, 'a', 2);
+        temp.addTransition(2, EPSILON, 3);
+        temp.addTransition(2, EPSILON, 1);
         EXPECT_TRUE(areEqual(temp, res));
     }
 
@@ -153,32 +163,26 @@ namespace NFA_test {
          *   /  /   \   \
          *  * e * a * e *
          */
-        std::vector<std::unique_ptr<NFA::Node>> nodes(4);
-        for (auto &arrNode : nodes) {
-            arrNode = std::make_unique<NFA::Node>();
-        }
+        NFA temp(4, 0, 3);
         /*        e
          *    /   e   \
          *   /  /   \  \
          *  0 e 1 a 2 e 3
          */
-        nodes[0]->addTransition(EPSILON, nodes[1].get());
-        nodes[1]->addTransition('a', nodes[2].get());
-        nodes[2]->addTransition(EPSILON, nodes[3].get());
-        nodes[2]->addTransition(EPSILON, nodes[1].get());
+        temp.addTransition(0, EPSILON, 1);
+        temp.addTransition(1, 'a', 2);
+        temp.addTransition(2, EPSILON, 3);
+        temp.addTransition(2, EPSILON, 1);
         // Only difference between Positive_closure and Kleene_closure.
-        nodes[0]->addTransition(EPSILON, nodes[3].get());
-
-        auto start = nodes[0].get(), end = nodes.back().get();
-        NFA temp{start, end, std::move(nodes)};
+        temp.addTransition(0, EPSILON, 3);
         EXPECT_TRUE(areEqual(temp, res));
     }
 
     bool MatchRegexp(const std::string &s, const NFA &nfa) {
         NFA::Set st{nfa.get_start()};
-        st = E_closure(st);
+        st = nfa.E_closure(st);
         for (char c: s) {
-            st = E_closure(Move(st, c));
+            st = nfa.E_closure(nfa.Move(st, c));
         }
         if (st.count(nfa.get_end())) {
             return true;
@@ -200,4 +204,44 @@ namespace NFA_test {
     }
 
 
+    TEST(NFA_test, PrecomputedClosuresMatchTraversal) {
+        // (a* | b+)* (c | \L)
+        NFA a_closure = NFA_Builder().Concatenate('a').Kleene_closure().build();
+        NFA b_closure = NFA_Builder().Concatenate('b').Positive_closure().build();
+        NFA res = NFA_Builder(a_closure).Or(b_closure).Kleene_closure()
+                .Concatenate(NFA_Builder(NFA{'c'}).Or(NFA{}).build()).build();
+        NFA::Closures closures(res);
+        for (int id = 0; id < res.size(); id++) {
+            EXPECT_TRUE(closures.of(id) == res.E_closure({id})) << "Failed at node #" << id;
+        }
+        NFA::Set set{res.get_start(), res.get_end()};
+        EXPECT_TRUE(closures.of(set) == res.E_closure(set));
+    }
+
+    TEST(StateSet, InsertAndCount) {
+        NFA::Set set;
+        EXPECT_TRUE(set.empty());
+        EXPECT_TRUE(set.insert(3));
+        EXPECT_TRUE(set.insert(200));
+        EXPECT_FALSE(set.insert(3));
+        EXPECT_EQ(set.size(), 2);
+        EXPECT_EQ(set.count(3), 1);
+        EXPECT_EQ(set.count(200), 1);
+        EXPECT_EQ(set.count(4), 0);
+        EXPECT_EQ(set.count(100000), 0);
+        std::vector<int> ids;
+        set.for_each([&](int id) { ids.push_back(id); });
+        EXPECT_EQ(ids, (std::vector<int>{3, 200}));
+    }
+
+    TEST(StateSet, EqualSetsHaveEqualHashes) {
+        NFA::Set a{1, 70, 500};
+        NFA::Set b{500};
+        b |= NFA::Set{1, 70};
+        EXPECT_TRUE(a == b);
+        EXPECT_EQ(std::hash<NFA::Set>{}(a), std::hash<NFA::Set>{}(b));
+        EXPECT_TRUE(NFA::Set{} == NFA::Set{});
+        EXPECT_TRUE(NFA::Set{1} != NFA::Set{2});
+        EXPECT_NE(std::hash<NFA::Set>{}(NFA::Set{1}), std::hash<NFA::Set>{}(NFA::Set{2}));
+    }
 }
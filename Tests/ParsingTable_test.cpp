@@ -83,6 +83,43 @@ namespace ParsingTable_tests{
             Symbol nonTerminal = {entry[0],Symbol::Type ::NON_TERMINAL};
             Symbol terminal = {entry[1],Symbol::Type ::TERMINAL};
             EXPECT_FALSE(table.hasProduction(nonTerminal,terminal));
+            EXPECT_THROW(table.getProduction(nonTerminal,terminal), std::out_of_range);
         }
+        EXPECT_THROW(table.getProduction({"Z",Symbol::Type::NON_TERMINAL},{"i",Symbol::Type::TERMINAL}), std::out_of_range);
+        EXPECT_THROW(table.getProduction({"E",Symbol::Type::NON_TERMINAL},{"z",Symbol::Type::TERMINAL}), std::out_of_range);
     }
-}
\ No newline at end of file
+
+    TEST(denseTable, entriesIndexFlatProductions) {
+        //E  -> TR
+        //R  -> +T R| #
+        //T  -> 'i'
+        std::unordered_map<Symbol, Rule> rules = {
+                {{"E", Symbol::Type::NON_TERMINAL}, writeRule("E", writeProductions({"T R"}))},
+                {{"R", Symbol::Type::NON_TERMINAL}, writeRule("R", writeProductions({"'+' T R", "#"}))},
+                {{"T", Symbol::Type::NON_TERMINAL}, writeRule("T", writeProductions({"'i'"}))}
+        };
+        Symbol first_symbol = {"E", Symbol::Type::NON_TERMINAL};
+        Syntax_Utils utils_syntax(rules, first_symbol);
+        ParsingTable table = ParsingTable(rules,utils_syntax);
+        EXPECT_FALSE(table.fail());
+
+        auto id = [&](const std::string &name, Symbol::Type type){ return table.getId({name, type}); };
+        const int plus = id("+", Symbol::Type::TERMINAL), end = id("$", Symbol::Type::TERMINAL);
+        const int R = id("R", Symbol::Type::NON_TERMINAL), T = id("T", Symbol::Type::NON_TERMINAL);
+        EXPECT_TRUE(table.isTerminal(plus) && table.isTerminal(end) && !table.isTerminal(R));
+        EXPECT_EQ(id("x", Symbol::Type::TERMINAL), -1);
+        EXPECT_EQ(table.getSymbol(R).name, "R");
+
+        const std::int16_t production = table.getEntry(R, plus);
+        ASSERT_GE(production, 0);
+        EXPECT_EQ(std::vector<int>(table.getProductionBegin(production), table.getProductionEnd(production)),
+                  (std::vector<int>{plus, T, R}));
+        // Epsilon is left out of the production's symbols.
+        const std::int16_t epsilon = table.getEntry(R, end);
+        ASSERT_GE(epsilon, 0);
+        EXPECT_EQ(table.getProductionBegin(epsilon), table.getProductionEnd(epsilon));
+        EXPECT_EQ(table.getEntry(T, plus), ParsingTable::SYNC_ENTRY);
+        EXPECT_GE(table.getEntry(T, id("i", Symbol::Type::TERMINAL)), 0);
+        EXPECT_EQ(table.getEntry(R, id("i", Symbol::Type::TERMINAL)), ParsingTable::NO_PRODUCTION);
+    }
+}
@@ -67,7 +67,7 @@ namespace CFG_Reader_tests {
 
         auto rules = reader.getRules();
         auto start_symbol = reader.getStartSymbol();
-        Symbol A_dash = {reader.getStartSymbol().name+"\'", Symbol::Type::NON_TERMINAL};
+        Symbol A_dash = {std::string(reader.getStartSymbol().name) + "\'", Symbol::Type::NON_TERMINAL};
 
         ASSERT_TRUE(isEqual(rules.at(start_symbol), expected_A));
         ASSERT_TRUE(isEqual(rules.at(A_dash), expected_A_dash));
@@ -91,7 +91,7 @@ namespace CFG_Reader_tests {
         expected_rules.insert({{"A2", Symbol::Type::NON_TERMINAL},
                                writeRule("A2", writeProductions({"'b' A3", "'a'"}))});
         expected_rules.insert({{"A3", Symbol::Type::NON_TERMINAL},
-                               writeRule("A3", writeProductions({"'z' 'z'", eps_symbol.name}))});
+                               writeRule("A3", writeProductions({"'z' 'z'", std::string(eps_symbol.name)}))});
 
         Rules_builder reader(tempCFGRulesFilePath);
         reader.buildLL1Grammar();
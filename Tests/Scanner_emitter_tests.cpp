@@ -0,0 +1,61 @@
+#include "gtest/gtest.h"
+#include <sstream>
+#include "../src/NFA/NFA_Builder.h"
+#include "../src/DFA/Scanner_emitter.h"
+#include "../src/Parser/LexicalParser.h"
+#include "lab_scanner.h"
+
+namespace Scanner_emitter_tests {
+
+    /**
+     * Longest prefix of s accepted by the DFA along with its token, the same way the lexical parser matches.
+     */
+    std::pair<int, std::size_t> longestMatch(const DFA &dfa, const std::string &s) {
+        std::pair<int, std::size_t> match{DFA::NOT_ACCEPTING, 0};
+        int state = DFA::START_STATE;
+        for (std::size_t i = 0; i < s.size(); i++) {
+            state = dfa.next(state, s[i]);
+            if (dfa.isAcceptingState(state)) {
+                match = {dfa.getToken(state), i + 1};
+            }
+        }
+        return match;
+    }
+
+    TEST(ScannerEmitter, TokenKindNames) {
+        DFA dfa({{";",     1, NFA{';'}},
+                 {"if",    2, NFA_Builder(NFA{'i'}).Concatenate('f').build()},
+                 {"_x3B",  3, NFA{'x'}},
+                 {"a b",   4, NFA{'b'}}});
+        EXPECT_EQ(Scanner_emitter::token_kind_names(dfa),
+                  (std::vector<std::string>{"TK__x3B", "TK_if", "TK__x3B_1", "TK_a_x20b"}));
+        EXPECT_EQ(Scanner_emitter::to_identifier("lab-scanner"), "lab_scanner");
+        EXPECT_EQ(Scanner_emitter::to_identifier("1st"), "_1st");
+    }
+
+    TEST(ScannerEmitter, EmitsEveryToken) {
+        DFA dfa({{"\"quoted\\", 1, NFA{'q'}}});
+        std::ostringstream out;
+        Scanner_emitter::emit(dfa, "quoted", out);
+        const std::string header = out.str();
+        EXPECT_NE(header.find("namespace quoted {"), std::string::npos);
+        EXPECT_NE(header.find("TK__x22quoted_x5C = 0,"), std::string::npos);
+        EXPECT_NE(header.find(R"("\"quoted\\")"), std::string::npos);
+    }
+
+    TEST(ScannerEmitter, GeneratedScannerMatchesDFA) {
+        LexicalParser lexicalParser(LAB_INPUT_PATH);
+        ASSERT_FALSE(lexicalParser.has_grammar_error());
+        const DFA &dfa = lexicalParser.get_DFA();
+        for (const std::string s : {"int", "integer", "sum,", "count", "while(", "!=", "!", "10)", "1.5E3;", "1.5E",
+                                    "1.", "<=>", "==", "+1", "-", "*/", "{", "}", "pass1", "X9y", "", "#", "é",
+                                    "boolean", "float1", "3.14"}) {
+            const auto [token, length] = longestMatch(dfa, s);
+            const lab_scanner::Match match = lab_scanner::longest_match(s.data(), s.data() + s.size());
+            EXPECT_EQ(static_cast<int>(match.kind), token) << s;
+            EXPECT_EQ(match.length, length) << s;
+            EXPECT_EQ(lab_scanner::token_name(match.kind),
+                      token == DFA::NOT_ACCEPTING ? "" : dfa.getTokenNames()[token]) << s;
+        }
+    }
+}
@@ -12,7 +12,7 @@ namespace Syntax_Utils_tests {
     void checkTerminalEquality(std::unordered_set<std::string> expected_terminals, const Syntax_Utils::Terminal_set& res_terminals) {
         EXPECT_EQ(res_terminals.size(), expected_terminals.size());
         for (const Symbol &s : res_terminals) {
-            EXPECT_TRUE(expected_terminals.find(s.name) != expected_terminals.end());
+            EXPECT_TRUE(expected_terminals.find(std::string(s.name)) != expected_terminals.end());
         }
     }
 
@@ -130,4 +130,110 @@ namespace Syntax_Utils_tests {
         }
 
     }
-}
\ No newline at end of file
+
+    TEST(SymbolInterning, SameNameSameId) {
+        std::string name = "EXPRESSION";
+        Symbol a{name, Symbol::Type::NON_TERMINAL};
+        name += "'";
+        Symbol b{name.substr(0, name.size() - 1), Symbol::Type::NON_TERMINAL};
+        // The interned name doesn't depend on the string it was made from.
+        EXPECT_EQ(a.name, "EXPRESSION");
+        EXPECT_EQ(a.id, b.id);
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(std::hash<Symbol>()(a), std::hash<std::string>()("EXPRESSION"));
+
+        Symbol terminal{"EXPRESSION", Symbol::Type::TERMINAL};
+        EXPECT_EQ(terminal.id, a.id);
+        EXPECT_NE(terminal, a);
+        EXPECT_NE(Symbol(name, Symbol::Type::NON_TERMINAL).id, a.id);
+        EXPECT_EQ(Symbol().id, Symbol("", Symbol::Type::TERMINAL).id);
+    }
+
+    TEST(FirstFollowConstruction, bitsetsMatchSets) {
+        std::unordered_map<Symbol, Rule> rules = {
+                {{"E", Symbol::Type::NON_TERMINAL}, writeRule("E", writeProductions({"T R"}))},
+                {{"R", Symbol::Type::NON_TERMINAL}, writeRule("R", writeProductions({"'+' T R", "#"}))},
+                {{"T", Symbol::Type::NON_TERMINAL}, writeRule("T", writeProductions({"F Y"}))},
+                {{"Y", Symbol::Type::NON_TERMINAL}, writeRule("Y", writeProductions({"'*' F Y", "#"}))},
+                {{"F", Symbol::Type::NON_TERMINAL}, writeRule("F", writeProductions({"'(' E ')'", "'i'"}))}
+        };
+        Syntax_Utils utils_syntax(rules, {"E", Symbol::Type::NON_TERMINAL});
+        // Terminals are sorted by name, $ included.
+        std::vector<std::string> terminals;
+        for (int i = 0; i < utils_syntax.terminal_count(); i++) {
+            terminals.emplace_back(utils_syntax.get_terminal(i).name);
+        }
+        EXPECT_EQ(terminals, std::vector<std::string>({"$", "(", ")", "*", "+", "i"}));
+
+        auto names = [&](const Syntax_Utils::Terminal_bitset &bits) {
+            std::unordered_set<std::string> set;
+            bits.for_each([&](int terminal) {
+                set.insert(std::string(utils_syntax.get_terminal(terminal).name));
+            });
+            return set;
+        };
+        for (const auto &[non_terminal, _] : rules) {
+            std::unordered_set<std::string> first = names(utils_syntax.first_bits(non_terminal));
+            if (utils_syntax.is_nullable(non_terminal)) {
+                first.insert("#");
+            }
+            checkTerminalEquality(first, utils_syntax.first_of(non_terminal));
+            checkTerminalEquality(names(utils_syntax.follow_bits(non_terminal)), utils_syntax.follow_of(non_terminal));
+        }
+
+        Syntax_Utils::Terminal_bitset production_first(utils_syntax.terminal_count());
+        EXPECT_TRUE(utils_syntax.first_bits(writeProductions({"R Y"})[0], production_first));
+        EXPECT_EQ(names(production_first), std::unordered_set<std::string>({"+", "*"}));
+        EXPECT_FALSE(utils_syntax.first_bits(writeProductions({"Y T"})[0], production_first));
+        EXPECT_EQ(names(production_first), std::unordered_set<std::string>({"*", "(", "i"}));
+    }
+
+    void checkFirstFollow(const Syntax_Utils &utils_syntax, const std::vector<std::string> &non_terminals,
+                          const std::vector<std::unordered_set<std::string>> &firsts,
+                          const std::vector<std::unordered_set<std::string>> &follows) {
+        for (int i = 0; i < non_terminals.size(); i++) {
+            Symbol non_terminal = {non_terminals[i], Symbol::Type::NON_TERMINAL};
+            checkTerminalEquality(firsts[i], utils_syntax.first_of(non_terminal));
+            checkTerminalEquality(follows[i], utils_syntax.follow_of(non_terminal));
+        }
+    }
+
+    TEST(FirstFollowConstruction, leftRecursion) {
+        //Input :
+        //E  -> E '+' T | T
+        //T  -> T '*' F | F
+        //F  -> '(' E ')' | 'i'
+        //L  -> L 'x' | #
+        std::unordered_map<Symbol, Rule> rules = {
+                {{"E", Symbol::Type::NON_TERMINAL}, writeRule("E", writeProductions({"E '+' T", "T"}))},
+                {{"T", Symbol::Type::NON_TERMINAL}, writeRule("T", writeProductions({"T '*' F", "F"}))},
+                {{"F", Symbol::Type::NON_TERMINAL}, writeRule("F", writeProductions({"'(' E ')'", "'i' L"}))},
+                {{"L", Symbol::Type::NON_TERMINAL}, writeRule("L", writeProductions({"L 'x'", "#"}))}
+        };
+        Syntax_Utils utils_syntax(rules, {"E", Symbol::Type::NON_TERMINAL});
+        checkFirstFollow(utils_syntax, {"E", "T", "F", "L"},
+                         {{"(", "i"}, {"(", "i"}, {"(", "i"}, {"x", "#"}},
+                         {{"$", "+", ")"}, {"$", "+", "*", ")"}, {"$", "+", "*", ")"}, {"$", "+", "*", ")", "x"}});
+    }
+
+    TEST(FirstFollowConstruction, mutualDependency) {
+        //Input :
+        //S  -> A 'e'
+        //A  -> B 'a' | C
+        //B  -> A 'b' | 'c'
+        //C  -> D | #
+        //D  -> C 'd'
+        std::unordered_map<Symbol, Rule> rules = {
+                {{"S", Symbol::Type::NON_TERMINAL}, writeRule("S", writeProductions({"A 'e'"}))},
+                {{"A", Symbol::Type::NON_TERMINAL}, writeRule("A", writeProductions({"B 'a'", "C"}))},
+                {{"B", Symbol::Type::NON_TERMINAL}, writeRule("B", writeProductions({"A 'b'", "'c'"}))},
+                {{"C", Symbol::Type::NON_TERMINAL}, writeRule("C", writeProductions({"D", "#"}))},
+                {{"D", Symbol::Type::NON_TERMINAL}, writeRule("D", writeProductions({"C 'd'"}))}
+        };
+        Syntax_Utils utils_syntax(rules, {"S", Symbol::Type::NON_TERMINAL});
+        // A is nullable through C, so B starts with what follows A in B -> A 'b' as well.
+        checkFirstFollow(utils_syntax, {"S", "A", "B", "C", "D"},
+                         {{"b", "c", "d", "e"}, {"b", "c", "d", "#"}, {"b", "c", "d"}, {"d", "#"}, {"d"}},
+                         {{"$"}, {"b", "e"}, {"a"}, {"b", "d", "e"}, {"b", "d", "e"}});
+    }
+}
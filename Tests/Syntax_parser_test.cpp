@@ -11,6 +11,7 @@
 #include "../src/Syntax_Parser/Syntax_parser.h"
 #include "Syntax_tests_helper.h"
 #include "../src/Syntax_Parser/Rules_builder.h"
+#include "../src/Syntax_Parser/Derivation_writer.h"
 
 namespace Syntax_parser_tests {
     class SyntaxParserTest : public ::testing::Test {
@@ -193,4 +194,95 @@ namespace Syntax_parser_tests {
         EXPECT_TRUE(syn_parser.fail());
     }
 
-}
\ No newline at end of file
+    TEST_F(SyntaxParserTest, ParseTree) {
+        LexicalParser lexicalParser(LAB_INPUT_PATH);
+        EXPECT_FALSE(lexicalParser.has_grammar_error());
+
+        writeProgram("WrongWord int x 5;");
+        lexicalParser.set_input_stream(tempProgramPath);
+
+        writeCFG("# ASSIGNMENT = DECLARATION 'assign' 'num' ';'",
+                 "# DECLARATION = PRIMITIVE_TYPE 'id'",
+                 "# PRIMITIVE_TYPE = 'int' | 'float'");
+        Rules_builder builder{tempCFGPath};
+        Syntax_parser syn_parser{builder.getRules(), builder.getStartSymbol()};
+
+        Parse_tree tree;
+        EXPECT_TRUE(syn_parser.parse(lexicalParser, tree) == Syntax_parser::Status::ACCEPTED_WITH_ERRORS);
+        // WrongWord is discarded but keeps its index.
+        ASSERT_EQ(tree.token_count(), 5);
+        EXPECT_EQ(tree.get_token_location(1).line, 1);
+        EXPECT_EQ(tree.get_token_location(1).column, 11);
+
+        const Parse_tree::Node *root = tree.get_root();
+        ASSERT_EQ(root->child_count, 4);
+        const Parse_tree::Node &declaration = root->children[0];
+        EXPECT_EQ(tree.get_symbol(declaration).name, "DECLARATION");
+        ASSERT_EQ(declaration.child_count, 2);
+        EXPECT_EQ(declaration.children[0].children[0].token, 1);
+        EXPECT_EQ(declaration.children[1].token, 2);
+        // 'assign' is missing and inserted.
+        EXPECT_EQ(tree.get_symbol(root->children[1]).name, "assign");
+        EXPECT_EQ(root->children[1].token, Parse_tree::NO_TOKEN);
+        EXPECT_EQ(root->children[2].token, 3);
+        EXPECT_EQ(root->children[3].token, 4);
+
+        std::stringstream written;
+        tree.write(written);
+        EXPECT_EQ(written.str(), "ASSIGNMENT\n"
+                                 "  DECLARATION\n"
+                                 "    PRIMITIVE_TYPE\n"
+                                 "      'int' line 1, column 11\n"
+                                 "    'id' line 1, column 15\n"
+                                 "  'assign' (missing)\n"
+                                 "  'num' line 1, column 17\n"
+                                 "  ';' line 1, column 18\n");
+
+        std::vector<std::vector<Symbol>> expected{
+                writeSymbols({"ASSIGNMENT"}),
+                writeSymbols({"DECLARATION", "'assign'", "'num'", "';'"}),
+                writeSymbols({"PRIMITIVE_TYPE", "'id'", "'assign'", "'num'", "';'"}),
+                writeSymbols({"'int'", "'id'", "'assign'", "'num'", "';'"}),
+        };
+        std::vector<std::vector<Symbol>> actual;
+        Parse_tree::Leftmost_derivation derivation{tree};
+        for (std::vector<Symbol> form; derivation.next(form);) {
+            actual.push_back(form);
+        }
+        EXPECT_TRUE(expected == actual);
+    }
+
+    TEST_F(SyntaxParserTest, DerivationWriter) {
+        LexicalParser lexicalParser(LAB_INPUT_PATH);
+        EXPECT_FALSE(lexicalParser.has_grammar_error());
+
+        writeCFG("# ASSIGNMENT = DECLARATION 'assign' 'num' ';'",
+                 "# DECLARATION = PRIMITIVE_TYPE 'id'",
+                 "# PRIMITIVE_TYPE = 'int' | 'float'");
+        Rules_builder builder{tempCFGPath};
+        Syntax_parser syn_parser{builder.getRules(), builder.getStartSymbol()};
+
+        writeProgram("int x 5;");
+        lexicalParser.set_input_stream(tempProgramPath);
+        std::stringstream forms;
+        {
+            Derivation_writer writer{forms, Derivation_writer::Format::FORMS};
+            EXPECT_TRUE(syn_parser.parse(lexicalParser, writer) == Syntax_parser::Status::ACCEPTED_WITH_ERRORS);
+        }
+        EXPECT_EQ(forms.str(), "ASSIGNMENT \n"
+                               "DECLARATION 'assign' 'num' ';' \n"
+                               "PRIMITIVE_TYPE 'id' 'assign' 'num' ';' \n"
+                               "'int' 'id' 'assign' 'num' ';' \n");
+
+        lexicalParser.set_input_stream(tempProgramPath);
+        std::stringstream deltas;
+        {
+            Derivation_writer writer{deltas, Derivation_writer::Format::DELTAS};
+            syn_parser.parse(lexicalParser, writer);
+        }
+        EXPECT_EQ(deltas.str(), "ASSIGNMENT\n"
+                                "ASSIGNMENT -> DECLARATION 'assign' 'num' ';'\n"
+                                "DECLARATION -> PRIMITIVE_TYPE 'id'\n"
+                                "PRIMITIVE_TYPE -> 'int'\n");
+    }
+}
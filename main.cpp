@@ -1,10 +1,41 @@
+#include <array>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <streambuf>
 #include "chrono"
 #include "src/Parser/InputParser.h"
 #include "src/Parser/Utils/ParserUtils.h"
 #include "src/Parser/LexicalParser.h"
+#include "src/DFA/Scanner_emitter.h"
 #include "src/Syntax_Parser/Rules_builder.h"
 #include "src/Syntax_Parser/Syntax_parser.h"
+#include "src/Syntax_Parser/LR_parser.h"
+#include "src/Syntax_Parser/Derivation_writer.h"
+
+namespace {
+    /**
+     * Unbuffered stream buffer writing to a C file, e.g one made by std::tmpfile.
+     */
+    class File_streambuf : public std::streambuf {
+    public:
+        explicit File_streambuf(std::FILE *file) : file(file) {
+        }
+
+    protected:
+        std::streamsize xsputn(const char *s, std::streamsize n) override {
+            return static_cast<std::streamsize>(std::fwrite(s, 1, static_cast<std::size_t>(n), file));
+        }
+
+        int_type overflow(int_type c) override {
+            return traits_type::eq_int_type(c, traits_type::eof()) ? traits_type::not_eof(c) : std::fputc(c, file);
+        }
+
+    private:
+        std::FILE *file;
+    };
+}
 
 #define debug(...) fprintf(stderr, __VA_ARGS__), fflush(stderr)
 
@@ -20,44 +51,155 @@ int main(int argc, char *argv[])
 {
     using namespace std;
     time__("Execution") {
-        if (argc != 4) {
-            std::cerr << "Error: You need to specify both the rules file path and program file path." << "\n";
-            std::cerr << "Usage: " << argv[0] << " rulesFilePath CFGFilePath programFilePath" << "\n";
+        const std::string DFA_IMAGE_OPTION{"--dfa-image="};
+        const std::string EMIT_SCANNER_OPTION{"--emit-scanner="};
+        const std::string LEX_THREADS_OPTION{"--lex-threads="};
+        const std::string PARSER_OPTION{"--parser="};
+        const std::string OUTPUT_OPTION{"--output="};
+        std::vector<std::string> paths;
+        std::string dfaImagePath, scannerPath, parserName{"ll1"}, outputMode{"derivation"};
+        unsigned lexThreads = 1;
+        for (int i = 1; i < argc; i++) {
+            std::string argument{argv[i]};
+            if (argument.rfind(DFA_IMAGE_OPTION, 0) == 0) {
+                dfaImagePath = argument.substr(DFA_IMAGE_OPTION.size());
+            } else if (argument.rfind(EMIT_SCANNER_OPTION, 0) == 0) {
+                scannerPath = argument.substr(EMIT_SCANNER_OPTION.size());
+            } else if (argument.rfind(LEX_THREADS_OPTION, 0) == 0) {
+                const std::string threads{argument.substr(LEX_THREADS_OPTION.size())};
+                // Counts which aren't a positive number of at most 4 digits are left at 0, which is rejected below.
+                const bool isCount = !threads.empty() && threads.size() <= 4 &&
+                                     threads.find_first_not_of("0123456789") == std::string::npos;
+                lexThreads = isCount ? std::stoul(threads) : 0;
+            } else if (argument.rfind(PARSER_OPTION, 0) == 0) {
+                parserName = argument.substr(PARSER_OPTION.size());
+            } else if (argument.rfind(OUTPUT_OPTION, 0) == 0) {
+                outputMode = argument.substr(OUTPUT_OPTION.size());
+            } else {
+                paths.push_back(argument);
+            }
+        }
+        std::string usageError;
+        // Emitting a scanner only needs the rules file.
+        if (paths.size() != (scannerPath.empty() ? 3 : 1)) {
+            usageError = "You need to specify both the rules file path and program file path.";
+        } else if (lexThreads == 0) {
+            usageError = "--lex-threads needs a number of threads from 1 to 9999.";
+        } else if (parserName != "ll1" && parserName != "lalr") {
+            usageError = "Unknown parser \"" + parserName + "\".";
+        } else if (outputMode != "derivation" && outputMode != "deltas" && outputMode != "tree") {
+            usageError = "Unknown output \"" + outputMode + "\".";
+        } else if (parserName == "lalr" && outputMode != "derivation") {
+            usageError = "--parser=lalr only outputs its reductions, so it can't be used with --output=" + outputMode +
+                         ".";
+        }
+        if (!usageError.empty()) {
+            std::cerr << "Error: " << usageError << "\n";
+            std::cerr << "Usage: " << argv[0] << " [--dfa-image=DFAImagePath] [--lex-threads=N] [--parser=ll1|lalr]"
+                      << " [--output=derivation|deltas|tree] rulesFilePath CFGFilePath"
+                      << " programFilePath|-" << "\n";
+            std::cerr << "       " << argv[0] << " [--dfa-image=DFAImagePath] --emit-scanner=headerPath rulesFilePath"
+                      << "\n";
             return 0;
         }
-        std::string rulesPath{argv[1]};
-        LexicalParser lexicalParser(rulesPath);
+        std::string rulesPath{paths[0]};
+        LexicalParser lexicalParser = dfaImagePath.empty() ? LexicalParser(rulesPath)
+                                                           : LexicalParser(rulesPath, dfaImagePath);
         if (lexicalParser.has_grammar_error()) {
             std::cerr << "Error: Couldn't Parse Grammar file correctly" << "\n";
             return 0;
         }
-        std::string programPath{argv[3]};
-        lexicalParser.set_input_stream(programPath);
+        if (!scannerPath.empty()) {
+            std::ofstream scannerFile{scannerPath};
+            if (!scannerFile.is_open()) {
+                std::cerr << "Error: Couldn't create scanner file." << "\n";
+                return 0;
+            }
+            // The namespace is named after the header, e.g scanner.h defines namespace scanner.
+            std::string name = scannerPath.substr(scannerPath.find_last_of("/\\") + 1);
+            name = name.substr(0, name.find('.'));
+            Scanner_emitter::emit(lexicalParser.get_DFA(), Scanner_emitter::to_identifier(name), scannerFile);
+            return 0;
+        }
+        std::string programPath{paths[2]};
+        // The program is streamed from the standard input when its path is "-", which is scanned on a single thread.
+        if (programPath == "-") {
+            if (lexThreads > 1) {
+                std::cerr << "Error: --lex-threads needs a program file, the standard input is scanned on a single"
+                          << " thread." << "\n";
+                return 0;
+            }
+            lexicalParser.set_input_stream(std::cin);
+        } else if (lexThreads > 1) {
+            lexicalParser.set_input_stream(programPath, lexThreads);
+        } else {
+            lexicalParser.set_input_stream(programPath);
+        }
 
-        std::string cfgPath{argv[2]};
+        std::string cfgPath{paths[1]};
         Rules_builder builder{cfgPath};
         if (builder.fail()) {
             std::cerr << "Failed reading CFG file rules.\n";
             return 0;
         }
-        builder.buildLL1Grammar();
-        Syntax_parser syn_parser{builder.getRules(), builder.getStartSymbol()};
-
         std::ofstream outputFile{"output.txt"};
         if (!outputFile.is_open()) {
             std::cerr << "Error: Couldn't create output file." << "\n";
             return 0;
         }
-        auto[derivation, status] = syn_parser.parse(lexicalParser);
-
         std::array<std::string, 3> status_to_string{"Accepted", "Accepted with errors", "Not matched"};
-        outputFile << "Syntax parser status: " << status_to_string[static_cast<int>(status)] << "\n";
-        for (const std::vector<Symbol> &cur: derivation) {
-            for (const Symbol &symbol: cur) {
-                outputFile << ((symbol.type == Symbol::Type::TERMINAL) ? ("'" + symbol.name + "'") : symbol.name);
-                outputFile << " ";
+
+        // The LALR(1) parser takes the rules as they are written and outputs the reductions, one per line.
+        if (parserName == "lalr") {
+            LR_parser lr_parser{builder.getRules(), builder.getStartSymbol()};
+            auto[reductions, status] = lr_parser.parse(lexicalParser);
+            const LALR_table &table = lr_parser.get_table();
+            outputFile << "Syntax parser status: " << status_to_string[static_cast<int>(status)] << "\n";
+            for (int production : reductions) {
+                outputFile << table.get_symbol(table.get_lhs(production)).name << " ->";
+                for (const int *id = table.get_production_begin(production);
+                     id != table.get_production_end(production); id++) {
+                    const Symbol &symbol = table.get_symbol(*id);
+                    if (symbol.type == Symbol::Type::TERMINAL) {
+                        outputFile << " '" << symbol.name << "'";
+                    } else {
+                        outputFile << " " << symbol.name;
+                    }
+                }
+                outputFile << "\n";
+            }
+        } else {
+            builder.buildLL1Grammar();
+            Syntax_parser syn_parser{builder.getRules(), builder.getStartSymbol()};
+            if (outputMode == "tree") {
+                Parse_tree tree;
+                const Syntax_parser::Status status = syn_parser.parse(lexicalParser, tree);
+                outputFile << "Syntax parser status: " << status_to_string[static_cast<int>(status)] << "\n";
+                tree.write(outputFile);
+            } else {
+                // The derivation is written while parsing, but after the status which is known only at the end, so
+                // it goes through an anonymous temporary file which is then appended to the output.
+                std::unique_ptr<std::FILE, int (*)(std::FILE *)> derivationFile{std::tmpfile(), std::fclose};
+                if (derivationFile == nullptr) {
+                    std::cerr << "Error: Couldn't create output file." << "\n";
+                    return 0;
+                }
+                Syntax_parser::Status status;
+                {
+                    File_streambuf derivationBuffer{derivationFile.get()};
+                    std::ostream derivationStream{&derivationBuffer};
+                    Derivation_writer writer{derivationStream, outputMode == "deltas"
+                                                               ? Derivation_writer::Format::DELTAS
+                                                               : Derivation_writer::Format::FORMS};
+                    status = syn_parser.parse(lexicalParser, writer);
+                }
+                outputFile << "Syntax parser status: " << status_to_string[static_cast<int>(status)] << "\n";
+                std::rewind(derivationFile.get());
+                std::vector<char> chunk(Derivation_writer::BUFFER_SIZE);
+                while (std::size_t read = std::fread(chunk.data(), 1, chunk.size(), derivationFile.get())) {
+                    outputFile.write(chunk.data(), static_cast<std::streamsize>(read));
+                }
             }
-            outputFile << "\n";
         }
     }
     return 0;
@@ -2,86 +2,287 @@
 // Created by hazem and ziad and mahmoud and kareem on 5/2/2021.
 //
 
+#include <algorithm>
 #include "DFA.h"
 
-const std::vector<DFA::State> &DFA::getStates() const {
-    return states;
-}
-
-DFA::DFA(const std::vector<RegularExpression> &regEXPs) {
+DFA::DFA(const std::vector<RegularExpression> &regEXPs, Minimization minimization) {
+    // Regular expressions sharing the same name accept the same token.
+    std::unordered_map<std::string, int> tokenIds;
+    std::vector<int> regEXPTokens;
+    for (const auto &regEXP : regEXPs) {
+        auto it = tokenIds.find(regEXP.getName());
+        if (it == tokenIds.end()) {
+            it = tokenIds.insert({regEXP.getName(), (int) tokenNames.size()}).first;
+            tokenNames.push_back(regEXP.getName());
+        }
+        regEXPTokens.push_back(it->second);
+    }
+    // All regular expressions are combined into a single NFA so that all nodes share the same id space.
+    std::vector<const NFA *> alternatives;
+    for (const auto &regEXP : regEXPs) {
+        alternatives.push_back(&regEXP.getNFA());
+    }
+    std::vector<int> acceptingIds;
+    const NFA nfa(alternatives, &acceptingIds);
+    const NFA::Closures closures(nfa);
+    build_char_classes(nfa);
+    // Any char of a class can stand for the whole class while moving NFA states.
+    std::vector<char> representatives(classCount);
+    for (int c = BYTE_VALUES - 1; c >= 0; c--) {
+        representatives[charClasses[c]] = static_cast<char>(c);
+    }
+    // Row-major transitions of the states constructed so far, classCount columns per state.
+    std::vector<int> transitions;
     std::queue<NFA::Set> unmarked_states;
     // Maps a given set of NFA nodes to its corresponding DFA state ID.
     std::unordered_map<NFA::Set, int> visited;
-    // Set of all starting NFA nodes.
-    NFA::Set start;
-    for (const auto &regEXP : regEXPs) {
-        start.insert(regEXP.getNFA().get_start());
-    }
-    start = E_closure(start);
+    NFA::Set start = closures.of(nfa.get_start());
     int state_id = 0;
-    visited[start] = state_id;
-    states.emplace_back(state_id++);
+    visited[start] = state_id++;
+    transitions.resize(classCount);
     unmarked_states.push(start);
     while (!unmarked_states.empty()) {
         auto current = std::move(unmarked_states.front());
         unmarked_states.pop();
         int index = visited.at(current);
-        set_if_accepting_state(states[index], current, regEXPs);
-        for (char c = 1; c < CHAR_MAX; ++c) {// start from 1 since 0 is reserved for EPSILON.
-            NFA::Set next = E_closure(Move(current, c));
+        accepting.push_back(get_accepted_token(current, regEXPs, regEXPTokens, acceptingIds));
+        // Class 0 holds no transitions at all so it always leads to the empty set.
+        for (int k = 0; k < classCount; ++k) {
+            NFA::Set next = (k == 0) ? NFA::Set() : closures.of(nfa.Move(current, representatives[k]));
             auto it = visited.find(next);
             if (it == visited.end()) {
-                it = visited.insert({next,state_id}).first;
+                it = visited.insert({next,state_id++}).first;
                 unmarked_states.emplace(std::move(next));
-                states.emplace_back(state_id++);
+                transitions.resize(transitions.size() + classCount);
             }
-            states[index].transitions[c] = it->second;
+            transitions[index * classCount + k] = it->second;
+        }
+    }
+    this->minimize_DFA(transitions, minimization);
+    this->find_dead_state();
+}
+
+DFA::DFA(Transition_table table, const std::array<std::uint8_t, BYTE_VALUES> &charClasses,
+         std::vector<int> accepting, std::vector<std::string> tokenNames) : table(std::move(table)),
+                                                                           charClasses(charClasses),
+                                                                           accepting(std::move(accepting)),
+                                                                           tokenNames(std::move(tokenNames)) {
+    classCount = this->table.columns();
+    find_dead_state();
+}
+
+void DFA::find_dead_state() {
+    deadState = NO_DEAD_STATE;
+    for (int state = 0; state < size() && deadState == NO_DEAD_STATE; state++) {
+        bool dead = !isAcceptingState(state);
+        for (int k = 0; k < classCount && dead; k++) {
+            dead = table.at(state, k) == state;
+        }
+        if (dead) {
+            deadState = state;
+        }
+    }
+}
+
+/**
+ * Partitions the bytes into equivalence classes such that two bytes are in the same class if every NFA node has
+ * the same transitions on both of them. Hence, the subset construction and the minimization only need to consider
+ * a single char per class instead of every char.
+ */
+void DFA::build_char_classes(const NFA &nfa) {
+    // Initially, all bytes are in class 0 which is then refined by the chars of every NFA node's transitions.
+    charClasses.fill(0);
+    classCount = 1;
+    for (int id = 0; id < nfa.size(); id++) {
+        // Chars leading to exactly the same nodes can't be distinguished by this node.
+        // The ends of the edges' ranges split the bytes into segments whose chars all lead to the same nodes.
+        std::vector<int> bounds;
+        nfa.for_each_edge(id, [&](const NFA::Edge &edge) {
+            if (!edge.is_epsilon()) {
+                bounds.push_back(edge.lo);
+                bounds.push_back(edge.hi + 1);
+            }
+        });
+        std::sort(bounds.begin(), bounds.end());
+        bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+        std::map<std::vector<int>, std::vector<unsigned char>> charsByTargets;
+        for (int i = 0; i + 1 < (int) bounds.size(); i++) {
+            std::vector<int> targets;
+            nfa.for_each_edge(id, [&](const NFA::Edge &edge) {
+                if (!edge.is_epsilon() && edge.lo <= bounds[i] && bounds[i] <= edge.hi) {
+                    targets.push_back((int) edge.to);
+                }
+            });
+            if (targets.empty()) {
+                continue;
+            }
+            std::sort(targets.begin(), targets.end());
+            std::vector<unsigned char> &chars = charsByTargets[targets];
+            for (int c = bounds[i]; c < bounds[i + 1]; c++) {
+                chars.push_back(static_cast<unsigned char>(c));
+            }
+        }
+        for (const auto &[_, chars] : charsByTargets) {
+            refine_char_classes(chars);
         }
     }
-    int empty_set_index = visited.at(NFA::Set());
-    for (auto &state : states) {
-        state.transitions[0] = empty_set_index;
+}
+
+/**
+ * Splits every class that is partially covered by the given chars into the covered and uncovered parts.
+ */
+void DFA::refine_char_classes(const std::vector<unsigned char> &chars) {
+    std::vector<int> classSize(classCount), covered(classCount);
+    for (int c = 0; c < BYTE_VALUES; c++) {
+        classSize[charClasses[c]]++;
+    }
+    for (unsigned char c : chars) {
+        covered[charClasses[c]]++;
+    }
+    std::vector<int> splitClass(classCount, -1);
+    for (unsigned char c : chars) {
+        int oldClass = charClasses[c];
+        if (covered[oldClass] == classSize[oldClass]) {
+            continue;
+        }
+        if (splitClass[oldClass] == -1) {
+            splitClass[oldClass] = classCount++;
+        }
+        charClasses[c] = splitClass[oldClass];
     }
-    this->minimize_DFA();
 }
 
 /**
- * Sets the the DFA state to be an accepting state if it contains any accepting NFA nodes. If there are multiple, It picks
- * the regular expression with minimal priority, i.e the earliest regular expression.
+ * Once the DFA is minimized, classes whose columns are identical in every state are merged, which shrinks the
+ * transition table. Classes are renumbered in the order of their smallest byte so that class 0 still holds EPSILON.
  */
-void DFA::set_if_accepting_state(DFA::State &state, const NFA::Set &set, const std::vector<RegularExpression> &regEXPs) {
+void DFA::merge_char_classes(std::vector<int> &transitions) {
+    const int states = (int) accepting.size();
+    std::map<std::vector<int>, int> columnClass;
+    std::vector<int> newClass(classCount, -1);
+    std::vector<int> newTransitions;
+    for (int c = 0; c < BYTE_VALUES; c++) {
+        int oldClass = charClasses[c];
+        if (newClass[oldClass] != -1) {
+            continue;
+        }
+        std::vector<int> column(states);
+        for (int state = 0; state < states; state++) {
+            column[state] = transitions[state * classCount + oldClass];
+        }
+        auto it = columnClass.find(column);
+        if (it == columnClass.end()) {
+            it = columnClass.insert({std::move(column), (int) columnClass.size()}).first;
+        }
+        newClass[oldClass] = it->second;
+    }
+    const int newClassCount = (int) columnClass.size();
+    newTransitions.resize(states * newClassCount);
+    for (int oldClass = 0; oldClass < classCount; oldClass++) {
+        for (int state = 0; state < states; state++) {
+            newTransitions[state * newClassCount + newClass[oldClass]] = transitions[state * classCount + oldClass];
+        }
+    }
+    for (auto &charClass : charClasses) {
+        charClass = newClass[charClass];
+    }
+    classCount = newClassCount;
+    transitions = std::move(newTransitions);
+}
+
+int DFA::size() const {
+    return (int) accepting.size();
+}
+
+int DFA::getClassCount() const {
+    return classCount;
+}
+
+const std::array<std::uint8_t, DFA::BYTE_VALUES> &DFA::getCharClasses() const {
+    return charClasses;
+}
+
+int DFA::next(int state, char c) const {
+    return table.at(state, column_of(c));
+}
+
+bool DFA::isAcceptingState(int state) const {
+    return accepting[state] != NOT_ACCEPTING;
+}
+
+int DFA::getToken(int state) const {
+    return accepting[state];
+}
+
+const std::string &DFA::getRegEXP(int state) const {
+    static const std::string NO_REG_EXP;
+    return isAcceptingState(state) ? tokenNames[accepting[state]] : NO_REG_EXP;
+}
+
+const Transition_table &DFA::getTable() const {
+    return table;
+}
+
+int DFA::getDeadState() const {
+    return deadState;
+}
+
+const std::vector<int> &DFA::getAcceptingTokens() const {
+    return accepting;
+}
+
+const std::vector<std::string> &DFA::getTokenNames() const {
+    return tokenNames;
+}
+
+/**
+ * Returns the token accepted by the DFA state corresponding to the given set of NFA nodes, i.e the token of the
+ * regular expression with minimal priority, i.e the earliest regular expression, whose accepting node is in the set.
+ * Returns NOT_ACCEPTING if the set contains no accepting NFA nodes.
+ */
+int DFA::get_accepted_token(const NFA::Set &set, const std::vector<RegularExpression> &regEXPs,
+                            const std::vector<int> &regEXPTokens, const std::vector<int> &acceptingIds) {
     int priority = INT_MAX;
-    for (const auto &regEXP : regEXPs) {
-        if (!set.count(regEXP.getNFA().get_end())) {
+    int token = NOT_ACCEPTING;
+    for (std::size_t i = 0; i < regEXPs.size(); i++) {
+        const auto &regEXP = regEXPs[i];
+        if (!set.count(acceptingIds[i])) {
             continue;
         }
         if (regEXP.getPriority() < priority) {
             priority = regEXP.getPriority();
-            state.regEXP = regEXP.getName();
-            state.isAcceptingState = true;
+            token = regEXPTokens[i];
         }
     }
+    return token;
 }
 
-void DFA::minimize_DFA() {
-    std::vector<int> statesClasses = classify();
-    std::vector<State> newStates;
-    //Add first state of every class to newStates.
-    for(int i=0 ; i< states.size() ;i++){
+void DFA::minimize_DFA(std::vector<int> &transitions, Minimization minimization) {
+    std::vector<int> statesClasses = classify(transitions, minimization);
+    std::vector<int> newTransitions;
+    std::vector<int> newAccepting;
+    //Add first state of every class to the new states.
+    for(std::size_t i=0 ; i< accepting.size() ;i++){
         // This condition means that this is the first state of class statesClasses[i].
         // First state of different classes are ordered.
-        if(statesClasses[i] == newStates.size()){
-            newStates.emplace_back(std::move(states[i]));
-            newStates.back().id = statesClasses[i];
-            newStates.back().transitions = transformTransitions(newStates.back().transitions,statesClasses);
+        if(statesClasses[i] == (int) newAccepting.size()){
+            newAccepting.push_back(accepting[i]);
+            std::vector<int> row = transformTransitions(&transitions[i * classCount], statesClasses);
+            newTransitions.insert(newTransitions.end(), row.begin(), row.end());
         }
     }
-    states = std::move(newStates);
+    accepting = std::move(newAccepting);
+    merge_char_classes(newTransitions);
+    table = Transition_table((int) accepting.size(), classCount, newTransitions);
 }
 
-std::vector<int> DFA::classify() {
+std::vector<int> DFA::classify(const std::vector<int> &transitions, Minimization minimization) {
     std::vector<int> statesClasses = init_classify();
-    reClassify(statesClasses);
+    if (minimization == Minimization::HOPCROFT) {
+        hopcroftClassify(transitions, statesClasses);
+    } else {
+        reClassify(transitions, statesClasses);
+    }
     return statesClasses;
 }
 
@@ -94,16 +295,16 @@ std::vector<int> DFA::init_classify() {
     // Class 0 is for not accepting states.
     // Positive classes are for accepting different regular expression.
     int nextClass = 1;
-    std::unordered_map<std::string,int> regExpClass;
-    std::vector<int> stateClass(states.size());
+    std::unordered_map<int,int> tokenClass;
+    std::vector<int> stateClass(accepting.size());
 
-    for(int i = 0 ; i< states.size() ; i++){
-        if(states[i].isAcceptingState){
-            if(regExpClass.find(states[i].regEXP) == regExpClass.end()){
-                regExpClass[states[i].regEXP] = nextClass;
+    for(std::size_t i = 0 ; i< accepting.size() ; i++){
+        if(accepting[i] != NOT_ACCEPTING){
+            if(tokenClass.find(accepting[i]) == tokenClass.end()){
+                tokenClass[accepting[i]] = nextClass;
                 nextClass++;
             }
-            stateClass[i] = regExpClass[states[i].regEXP];
+            stateClass[i] = tokenClass[accepting[i]];
         }else{
             stateClass[i] = 0;
         }
@@ -120,15 +321,15 @@ std::vector<int> DFA::init_classify() {
  * the partition cannot be refined further by breaking any group into smaller
  * groups, we have the minimum-state DFA.
 */
-void DFA::reClassify(std::vector<int> &statesClasses) {
-    std::vector<int> newStatesClasses(states.size());
+void DFA::reClassify(const std::vector<int> &transitions, std::vector<int> &statesClasses) {
+    std::vector<int> newStatesClasses(accepting.size());
     do{
         int nextClass = 0;
         std::map<std::pair<std::vector<int>,int>,int> classes;
 
-        for(int i = 0 ; i< states.size() ; i++){
+        for(std::size_t i = 0 ; i< accepting.size() ; i++){
             std::pair<std::vector<int>,int> key = {
-                    transformTransitions(states[i].transitions,statesClasses),
+                    transformTransitions(&transitions[i * classCount],statesClasses),
                     statesClasses[i]
             };
             if(classes.count(key) == 0){
@@ -143,11 +344,142 @@ void DFA::reClassify(std::vector<int> &statesClasses) {
 }
 
 /**
- * Maps each state in vector transitions to its corresponding class.
+ * Hopcroft's algorithm refines the initial partition using splitters (B, a), i.e the states whose transition on
+ * class a lead into block B. Every block X containing both such states and other states is split into two blocks.
+ * Only the smaller half of a split block needs to be used as a future splitter unless (X, a) is already waiting,
+ * which bounds the work by O(n.|Σ|.log n). On return, classes are numbered in the order of their first state.
  */
-std::vector<int> DFA::transformTransitions(const std::vector<int> &transitions, const std::vector<int> &statesClasses) {
-    std::vector<int> transitionClass(CHAR_MAX);
-    for(char c = 0 ; c < CHAR_MAX ; c++)
-        transitionClass[c] = statesClasses[transitions[c]];
+void DFA::hopcroftClassify(const std::vector<int> &transitions, std::vector<int> &statesClasses) {
+    const int n = (int) accepting.size();
+    // Inverse transitions grouped by (class, target) i.e sources of (a, t) are
+    // inverse[inverseStart[a * n + t] ... inverseStart[a * n + t + 1]).
+    std::vector<int> inverseStart(classCount * n + 1, 0);
+    std::vector<int> inverse(classCount * n);
+    for (int state = 0; state < n; state++) {
+        for (int a = 0; a < classCount; a++) {
+            inverseStart[a * n + transitions[state * classCount + a] + 1]++;
+        }
+    }
+    for (int i = 0; i < classCount * n; i++) {
+        inverseStart[i + 1] += inverseStart[i];
+    }
+    std::vector<int> fill(inverseStart.begin(), inverseStart.end() - 1);
+    for (int state = 0; state < n; state++) {
+        for (int a = 0; a < classCount; a++) {
+            inverse[fill[a * n + transitions[state * classCount + a]]++] = state;
+        }
+    }
+
+    // Blocks are contiguous ranges [blockBegin, blockEnd) of elements, positionOf[state] is the index of state
+    // in elements.
+    int blockCount = 1 + *std::max_element(statesClasses.begin(), statesClasses.end());
+    std::vector<int> elements(n), positionOf(n), blockOf(statesClasses);
+    std::vector<int> blockBegin(n + 1), blockEnd(n + 1), marked(n + 1, 0);
+    {
+        std::vector<int> blockSize(blockCount, 0);
+        for (int state = 0; state < n; state++) {
+            blockSize[blockOf[state]]++;
+        }
+        for (int block = 0, begin = 0; block < blockCount; block++) {
+            blockBegin[block] = blockEnd[block] = begin;
+            begin += blockSize[block];
+        }
+        for (int state = 0; state < n; state++) {
+            positionOf[state] = blockEnd[blockOf[state]]++;
+            elements[positionOf[state]] = state;
+        }
+    }
+
+    // Worklist of splitters, waiting[block * classCount + a] is true if (block, a) is in the worklist.
+    std::vector<std::pair<int, int>> worklist;
+    std::vector<bool> waiting((n + 1) * classCount, false);
+    auto addSplitter = [&](int block, int a) {
+        waiting[block * classCount + a] = true;
+        worklist.emplace_back(block, a);
+    };
+    // Using all blocks but the largest one as splitters is enough, as splitting by it is implied by the others.
+    int largestBlock = 0;
+    for (int block = 0; block < blockCount; block++) {
+        if (blockEnd[block] - blockBegin[block] > blockEnd[largestBlock] - blockBegin[largestBlock]) {
+            largestBlock = block;
+        }
+    }
+    for (int block = 0; block < blockCount; block++) {
+        for (int a = 0; a < classCount && block != largestBlock; a++) {
+            addSplitter(block, a);
+        }
+    }
+
+    std::vector<int> sources;
+    std::vector<int> touchedBlocks;
+    while (!worklist.empty()) {
+        auto [splitter, a] = worklist.back();
+        worklist.pop_back();
+        waiting[splitter * classCount + a] = false;
+
+        // Collect all states moving into the splitter on class a before any block gets split.
+        sources.clear();
+        for (int i = blockBegin[splitter]; i < blockEnd[splitter]; i++) {
+            const int target = elements[i];
+            sources.insert(sources.end(), inverse.begin() + inverseStart[a * n + target],
+                           inverse.begin() + inverseStart[a * n + target + 1]);
+        }
+
+        // Move marked states to the front of their blocks.
+        touchedBlocks.clear();
+        for (int state : sources) {
+            const int block = blockOf[state];
+            if (marked[block] == 0) {
+                touchedBlocks.push_back(block);
+            }
+            const int swapPosition = blockBegin[block] + marked[block]++;
+            const int swapState = elements[swapPosition];
+            std::swap(elements[positionOf[state]], elements[swapPosition]);
+            std::swap(positionOf[state], positionOf[swapState]);
+        }
+
+        for (int block : touchedBlocks) {
+            const int splitPosition = blockBegin[block] + marked[block];
+            marked[block] = 0;
+            if (splitPosition == blockEnd[block]) {
+                continue;
+            }
+            // The marked prefix becomes a new block.
+            const int newBlock = blockCount++;
+            blockBegin[newBlock] = blockBegin[block];
+            blockEnd[newBlock] = splitPosition;
+            blockBegin[block] = splitPosition;
+            for (int i = blockBegin[newBlock]; i < blockEnd[newBlock]; i++) {
+                blockOf[elements[i]] = newBlock;
+            }
+            const bool newIsSmaller = blockEnd[newBlock] - blockBegin[newBlock] <= blockEnd[block] - blockBegin[block];
+            for (int c = 0; c < classCount; c++) {
+                if (waiting[block * classCount + c]) {
+                    addSplitter(newBlock, c);
+                } else {
+                    addSplitter(newIsSmaller ? newBlock : block, c);
+                }
+            }
+        }
+    }
+
+    // Renumber the blocks in the order of their first state.
+    std::vector<int> blockClass(blockCount, -1);
+    int nextClass = 0;
+    for (int state = 0; state < n; state++) {
+        if (blockClass[blockOf[state]] == -1) {
+            blockClass[blockOf[state]] = nextClass++;
+        }
+        statesClasses[state] = blockClass[blockOf[state]];
+    }
+}
+
+/**
+ * Maps each state in the given row of transitions to its corresponding class.
+ */
+std::vector<int> DFA::transformTransitions(const int *transitions, const std::vector<int> &statesClasses) const {
+    std::vector<int> transitionClass(classCount);
+    for(int k = 0 ; k < classCount ; k++)
+        transitionClass[k] = statesClasses[transitions[k]];
     return transitionClass;
-}
\ No newline at end of file
+}
@@ -5,44 +5,116 @@
 #ifndef COMPILER_DFA_H
 #define COMPILER_DFA_H
 
+#include <array>
+#include <cstdint>
 #include <map>
 #include <vector>
 #include <climits>
 
 #include "../Parser/RegularExpression.h"
 #include "../NFA/NFA.h"
+#include "Transition_table.h"
 
 class DFA {
 public:
-    explicit DFA(const std::vector<RegularExpression> &regEXPs);
+    /**
+     * Algorithm used to merge indistinguishable states once the subset construction is done.
+     * HOPCROFT runs in O(n.|Σ|.log n) time, ITERATIVE is the straightforward partition refinement
+     * which is kept to cross-check the results.
+     */
+    enum class Minimization {
+        HOPCROFT,
+        ITERATIVE
+    };
 
-    struct State {
-        explicit State(int id) : id(id), isAcceptingState(false) {
-            transitions.resize(CHAR_MAX);
-        }
+    // Number of distinct byte values that can be fed to the DFA.
+    static constexpr int BYTE_VALUES = 1 << CHAR_BIT;
+    // Value stored in the accepting-token array for states that accept nothing.
+    static constexpr int NOT_ACCEPTING = -1;
+    static constexpr int START_STATE = 0;
+    // Returned by getDeadState() for DFAs without a dead state.
+    static constexpr int NO_DEAD_STATE = -1;
 
-        int id;
-        bool isAcceptingState;
-        std::string regEXP;
-        std::vector<int> transitions;
-    };
+    explicit DFA(const std::vector<RegularExpression> &regEXPs, Minimization minimization = Minimization::HOPCROFT);
+
+    /**
+     * Constructs a DFA from the parts of an already built one, see DFA_image. The number of classes is
+     * the number of columns of the table.
+     */
+    DFA(Transition_table table, const std::array<std::uint8_t, BYTE_VALUES> &charClasses,
+        std::vector<int> accepting, std::vector<std::string> tokenNames);
+
+    /**
+     * Returns the equivalence class of the given char, i.e its column in the transition table. Chars
+     * belonging to the same class are never distinguished by any state. Class 0 holds EPSILON along with
+     * every char that appears in none of the regular expressions, so it always leads to the empty-set state.
+     */
+    int column_of(char c) const {
+        return charClasses[static_cast<unsigned char>(c)];
+    }
+
+    int getClassCount() const;
+
+    const std::array<std::uint8_t, BYTE_VALUES> &getCharClasses() const;
+
+    int size() const;
+
+    int next(int state, char c) const;
 
-    const std::vector<State> &getStates() const;
+    bool isAcceptingState(int state) const;
+
+    /**
+     * Returns the id of the token accepted by the given state, i.e its index in getTokenNames(), or
+     * NOT_ACCEPTING if the state is not an accepting state.
+     */
+    int getToken(int state) const;
+
+    /**
+     * Returns the name of the regular expression accepted by the given state or an empty string if it is not
+     * an accepting state.
+     */
+    const std::string &getRegEXP(int state) const;
+
+    const Transition_table &getTable() const;
+
+    /**
+     * Returns the state which accepts nothing and never leaves itself, i.e once reached no longer input can be
+     * accepted, or NO_DEAD_STATE if there's no such state. The minimized DFA has at most one dead state.
+     */
+    int getDeadState() const;
+
+    const std::vector<int> &getAcceptingTokens() const;
+
+    const std::vector<std::string> &getTokenNames() const;
 
 private:
 
-    std::vector<State> states;
+    Transition_table table;
+    // Maps every byte to its equivalence class.
+    std::array<std::uint8_t, BYTE_VALUES> charClasses{};
+    int classCount{};
+    int deadState{NO_DEAD_STATE};
+    // Token id accepted by every state or NOT_ACCEPTING.
+    std::vector<int> accepting;
+    std::vector<std::string> tokenNames;
+
+    void find_dead_state();
+
+    void build_char_classes(const NFA &nfa);
+    void refine_char_classes(const std::vector<unsigned char> &chars);
+    void merge_char_classes(std::vector<int> &transitions);
 
-    void minimize_DFA();
-    std::vector<int> classify();
+    void minimize_DFA(std::vector<int> &transitions, Minimization minimization);
+    std::vector<int> classify(const std::vector<int> &transitions, Minimization minimization);
     std::vector<int> init_classify();
-    void reClassify(std::vector<int>& statesClasses);
-    std::vector<int> transformTransitions(const std::vector<int> &transitions,
-                                          const std::vector<int> &statesClasses);
+    void reClassify(const std::vector<int> &transitions, std::vector<int>& statesClasses);
+    void hopcroftClassify(const std::vector<int> &transitions, std::vector<int>& statesClasses);
+    std::vector<int> transformTransitions(const int *transitions, const std::vector<int> &statesClasses) const;
 
-    static void set_if_accepting_state(State &state, const NFA::Set &set, const std::vector<RegularExpression> &regEXPs);
+    static int get_accepted_token(const NFA::Set &set, const std::vector<RegularExpression> &regEXPs,
+                                  const std::vector<int> &regEXPTokens, const std::vector<int> &acceptingIds);
 
 };
 
 
-#endif //COMPILER_DFA_H
\ No newline at end of file
+#endif //COMPILER_DFA_H
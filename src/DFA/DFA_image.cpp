@@ -0,0 +1,149 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "DFA_image.h"
+#include "../Parser/Utils/MappedFile.h"
+
+namespace {
+    template<typename T>
+    void append(std::string &buffer, const T &value) {
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+}
+
+std::uint64_t DFA_image::hash_file(const std::string &path) {
+    MappedFile file(path);
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < file.size(); i++) {
+        hash ^= static_cast<unsigned char>(file.data()[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool DFA_image::write(const std::string &path, const DFA &dfa, std::uint64_t rules_hash, bool grammar_error) {
+    const Transition_table &table = dfa.getTable();
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.rules_hash = rules_hash;
+    header.grammar_error = grammar_error;
+    header.states = dfa.size();
+    header.classes = dfa.getClassCount();
+    header.cell_size = table.entry_size();
+    header.tokens = dfa.getTokenNames().size();
+
+    std::string buffer;
+    append(buffer, header);
+    buffer.append(reinterpret_cast<const char *>(dfa.getCharClasses().data()), DFA::BYTE_VALUES);
+    for (int token : dfa.getAcceptingTokens()) {
+        append(buffer, static_cast<std::int32_t>(token));
+    }
+    buffer.append(static_cast<const char *>(table.data()),
+                  static_cast<std::size_t>(table.rows()) * table.columns() * table.entry_size());
+    for (const std::string &name : dfa.getTokenNames()) {
+        append(buffer, static_cast<std::uint32_t>(name.size()));
+        buffer.append(name);
+    }
+
+    // Other processes may be writing or loading the same image, so it is written aside then renamed over.
+    const std::string temp_path = path + ".tmp" +
+                                  std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::ofstream file(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open() || !file.write(buffer.data(), buffer.size())) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        // Renaming over an existing file fails on some platforms.
+        std::remove(path.c_str());
+        if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+std::optional<DFA> DFA_image::load(const std::string &path, std::uint64_t rules_hash, bool *grammar_error) {
+    auto file = std::make_shared<MappedFile>(path);
+    if (!file->is_open() || file->size() < sizeof(Header)) {
+        return std::nullopt;
+    }
+    Header header{};
+    std::memcpy(&header, file->data(), sizeof(Header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.byte_order != BYTE_ORDER_MARK || header.rules_hash != rules_hash) {
+        return std::nullopt;
+    }
+    if (header.states == 0 || header.classes == 0 || header.classes > DFA::BYTE_VALUES ||
+        (header.cell_size != 1 && header.cell_size != 2 && header.cell_size != 4)) {
+        return std::nullopt;
+    }
+
+    // Offsets are computed in 64 bits so that corrupted counts can't overflow them.
+    const std::uint64_t classes_offset = sizeof(Header);
+    const std::uint64_t accepting_offset = classes_offset + DFA::BYTE_VALUES;
+    const std::uint64_t table_offset = accepting_offset + std::uint64_t{header.states} * sizeof(std::int32_t);
+    const std::uint64_t names_offset =
+            table_offset + std::uint64_t{header.states} * header.classes * header.cell_size;
+    if (names_offset > file->size()) {
+        return std::nullopt;
+    }
+    const char *data = file->data();
+
+    std::array<std::uint8_t, DFA::BYTE_VALUES> charClasses{};
+    std::memcpy(charClasses.data(), data + classes_offset, DFA::BYTE_VALUES);
+    for (std::uint8_t charClass : charClasses) {
+        if (charClass >= header.classes) {
+            return std::nullopt;
+        }
+    }
+
+    std::vector<int> accepting(header.states);
+    for (std::uint32_t state = 0; state < header.states; state++) {
+        std::int32_t token;
+        std::memcpy(&token, data + accepting_offset + state * sizeof(std::int32_t), sizeof(token));
+        if (token < DFA::NOT_ACCEPTING || token >= static_cast<std::int64_t>(header.tokens)) {
+            return std::nullopt;
+        }
+        accepting[state] = token;
+    }
+
+    std::vector<std::string> tokenNames;
+    std::uint64_t offset = names_offset;
+    for (std::uint32_t token = 0; token < header.tokens; token++) {
+        std::uint32_t length;
+        if (offset + sizeof(length) > file->size()) {
+            return std::nullopt;
+        }
+        std::memcpy(&length, data + offset, sizeof(length));
+        offset += sizeof(length);
+        if (offset + length > file->size()) {
+            return std::nullopt;
+        }
+        tokenNames.emplace_back(data + offset, length);
+        offset += length;
+    }
+
+    const void *cells = data + table_offset;
+    Transition_table table(static_cast<int>(header.states), static_cast<int>(header.classes),
+                           static_cast<int>(header.cell_size), file, cells);
+    const bool valid_cells = table.visit([&](const auto *cell) {
+        for (std::uint64_t i = 0; i < std::uint64_t{header.states} * header.classes; i++) {
+            if (cell[i] >= header.states) {
+                return false;
+            }
+        }
+        return true;
+    });
+    if (!valid_cells) {
+        return std::nullopt;
+    }
+    *grammar_error = header.grammar_error != 0;
+    return DFA(std::move(table), charClasses, std::move(accepting), std::move(tokenNames));
+}
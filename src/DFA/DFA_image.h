@@ -0,0 +1,65 @@
+#ifndef COMPILER_DFA_IMAGE_H
+#define COMPILER_DFA_IMAGE_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "DFA.h"
+
+/**
+ * Binary image of a built DFA so that later runs can skip building it from the rules file. The image is laid out
+ * as follows, all integers are stored in the byte order of the machine that wrote it:
+ *
+ *   Header                     see below
+ *   charClasses                BYTE_VALUES bytes
+ *   accepting tokens           int32 per state
+ *   transition table           states x classes cells of cell_size bytes each
+ *   token names                uint32 length followed by the bytes of each name
+ *
+ * The image is mapped read-only when loaded and the transition table is used in place without copying it.
+ */
+class DFA_image {
+public:
+    // Bumped whenever the layout changes so older images are rebuilt instead of misread.
+    static constexpr std::uint32_t VERSION = 1;
+
+    /**
+     * Returns the 64-bit FNV-1a hash of the given file's content, which keys an image by the rules it was built from.
+     */
+    static std::uint64_t hash_file(const std::string &path);
+
+    /**
+     * Writes the image of the given DFA to path, replacing any existing image at once so concurrent readers never
+     * see a partially written file. Returns false if the image couldn't be written.
+     */
+    static bool write(const std::string &path, const DFA &dfa, std::uint64_t rules_hash, bool grammar_error);
+
+    /**
+     * Maps the image stored at path and returns its DFA along with the grammar error flag it was written with.
+     * Returns std::nullopt if there's no such image, it was written by another version or byte order, it was
+     * built from rules of a different hash or it is malformed.
+     */
+    static std::optional<DFA> load(const std::string &path, std::uint64_t rules_hash, bool *grammar_error);
+
+private:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        // BYTE_ORDER_MARK as written by the machine that created the image.
+        std::uint32_t byte_order;
+        std::uint64_t rules_hash;
+        std::uint32_t grammar_error;
+        std::uint32_t states;
+        std::uint32_t classes;
+        std::uint32_t cell_size;
+        std::uint32_t tokens;
+        std::uint32_t reserved;
+    };
+
+    static constexpr char MAGIC[8] = {'D', 'F', 'A', 'I', 'M', 'A', 'G', 'E'};
+    static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+};
+
+
+#endif //COMPILER_DFA_IMAGE_H
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <unordered_set>
+#include "Scanner_emitter.h"
+
+namespace {
+    std::string hex_byte(unsigned char c) {
+        static const char *DIGITS = "0123456789ABCDEF";
+        return {DIGITS[c >> 4], DIGITS[c & 15]};
+    }
+}
+
+std::string Scanner_emitter::to_identifier(const std::string &name) {
+    std::string identifier;
+    for (char c : name) {
+        identifier.push_back(std::isalnum(static_cast<unsigned char>(c)) ? c : '_');
+    }
+    if (identifier.empty() || std::isdigit(static_cast<unsigned char>(identifier[0]))) {
+        identifier.insert(identifier.begin(), '_');
+    }
+    return identifier;
+}
+
+std::vector<std::string> Scanner_emitter::token_kind_names(const DFA &dfa) {
+    std::vector<std::string> names;
+    std::unordered_set<std::string> used;
+    for (const std::string &token : dfa.getTokenNames()) {
+        std::string name = "TK_";
+        for (char c : token) {
+            const auto byte = static_cast<unsigned char>(c);
+            if (std::isalnum(byte) || c == '_') {
+                name.push_back(c);
+            } else {
+                name += "_x" + hex_byte(byte);
+            }
+        }
+        // Different names may still be escaped to the same identifier, e.g ";" and "_x3B".
+        const std::string base = name;
+        for (int suffix = 1; used.count(name); suffix++) {
+            name = base + "_" + std::to_string(suffix);
+        }
+        used.insert(name);
+        names.push_back(std::move(name));
+    }
+    return names;
+}
+
+std::string Scanner_emitter::quote(const std::string &s) {
+    std::string quoted = "\"";
+    for (char c : s) {
+        const auto byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (std::isprint(byte)) {
+            quoted += c;
+        } else {
+            // Octal escapes have at most 3 digits so they can't swallow the following chars.
+            quoted += '\\';
+            quoted += static_cast<char>('0' + (byte >> 6));
+            quoted += static_cast<char>('0' + (byte >> 3 & 7));
+            quoted += static_cast<char>('0' + (byte & 7));
+        }
+    }
+    return quoted + "\"";
+}
+
+void Scanner_emitter::emit(const DFA &dfa, const std::string &name_space, std::ostream &out) {
+    const std::vector<std::string> kinds = token_kind_names(dfa);
+    const Transition_table &table = dfa.getTable();
+    // Scanning stops as soon as the dead state is reached.
+    std::vector<bool> dead(dfa.size());
+    if (dfa.getDeadState() != DFA::NO_DEAD_STATE) {
+        dead[dfa.getDeadState()] = true;
+    }
+    // Only states reached by some transition need a label.
+    std::vector<bool> referenced(dfa.size());
+    for (int state = 0; state < dfa.size(); state++) {
+        for (int k = 0; k < dfa.getClassCount() && !dead[state]; k++) {
+            referenced[table.at(state, k)] = true;
+        }
+    }
+
+    std::string guard = to_identifier(name_space) + "_H";
+    std::transform(guard.begin(), guard.end(), guard.begin(), [](unsigned char c) { return std::toupper(c); });
+    out << "// Generated from lexical rules, do not edit.\n"
+           "\n"
+           "#ifndef " << guard << "\n"
+           "#define " << guard << "\n"
+           "\n"
+           "#include <cstddef>\n"
+           "\n"
+           "namespace " << name_space << " {\n"
+           "\n"
+           "    enum class Token_kind : int {\n"
+           "        NONE = -1,\n";
+    for (int token = 0; token < (int) kinds.size(); token++) {
+        out << "        " << kinds[token] << " = " << token << ",\n";
+    }
+    out << "    };\n"
+           "\n"
+           "    inline const char *token_name(Token_kind kind) {\n"
+           "        static constexpr const char *NAMES[] = {";
+    for (const std::string &name : dfa.getTokenNames()) {
+        out << quote(name) << ", ";
+    }
+    out << "\"\"};\n"
+           "        return kind == Token_kind::NONE ? \"\" : NAMES[static_cast<int>(kind)];\n"
+           "    }\n"
+           "\n"
+           "    struct Match {\n"
+           "        Token_kind kind;\n"
+           "        std::size_t length;\n"
+           "    };\n"
+           "\n"
+           "    // Equivalence class of every byte.\n"
+           "    constexpr unsigned char CHAR_CLASSES[" << DFA::BYTE_VALUES << "] = {";
+    for (int c = 0; c < DFA::BYTE_VALUES; c++) {
+        out << (c % 32 == 0 ? "\n            " : " ") << static_cast<int>(dfa.getCharClasses()[c]) << ",";
+    }
+    out << "\n    };\n"
+           "\n"
+           "    /**\n"
+           "     * Returns the kind and length of the longest prefix of [begin, end) which is a token, or NONE and 0\n"
+           "     * if there's no such prefix.\n"
+           "     */\n"
+           "    inline Match longest_match(const char *begin, const char *end) {\n"
+           "        const char *p = begin;\n"
+           "        Match match{Token_kind::NONE, 0};\n";
+    for (int state = 0; state < dfa.size(); state++) {
+        if (dead[state]) {
+            continue;
+        }
+        if (referenced[state]) {
+            out << "    state_" << state << ":\n";
+        }
+        if (dfa.isAcceptingState(state)) {
+            out << "        match = {Token_kind::" << kinds[dfa.getToken(state)]
+                << ", static_cast<std::size_t>(p - begin)};\n";
+        }
+        // Classes are grouped by their next state, the most common one being the default case.
+        std::map<int, std::vector<int>> classesByTarget;
+        for (int k = 0; k < dfa.getClassCount(); k++) {
+            classesByTarget[table.at(state, k)].push_back(k);
+        }
+        int defaultTarget = -1;
+        for (const auto &[target, classes] : classesByTarget) {
+            if (defaultTarget == -1 || (dead[target] && !dead[defaultTarget]) ||
+                (dead[target] == dead[defaultTarget] && classes.size() > classesByTarget[defaultTarget].size())) {
+                defaultTarget = target;
+            }
+        }
+        if (classesByTarget.size() == 1 && dead[defaultTarget]) {
+            out << "        return match;\n";
+            continue;
+        }
+        out << "        if (p == end) {\n"
+               "            return match;\n"
+               "        }\n"
+               "        switch (CHAR_CLASSES[static_cast<unsigned char>(*p++)]) {\n";
+        for (const auto &[target, classes] : classesByTarget) {
+            if (target == defaultTarget) {
+                continue;
+            }
+            for (int k : classes) {
+                out << "            case " << k << ":\n";
+            }
+            out << "                " << (dead[target] ? "return match;" : "goto state_" + std::to_string(target) + ";")
+                << "\n";
+        }
+        out << "            default:\n"
+               "                " << (dead[defaultTarget] ? "return match;"
+                                                          : "goto state_" + std::to_string(defaultTarget) + ";")
+            << "\n"
+               "        }\n";
+    }
+    if (dead[DFA::START_STATE]) {
+        out << "        return match;\n";
+    }
+    out << "    }\n"
+           "\n"
+           "}\n"
+           "\n"
+           "#endif //" << guard << "\n";
+}
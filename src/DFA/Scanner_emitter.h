@@ -0,0 +1,41 @@
+#ifndef COMPILER_SCANNER_EMITTER_H
+#define COMPILER_SCANNER_EMITTER_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "DFA.h"
+
+/**
+ * Generates a self-contained C++ header scanning with a given DFA, so that it can be compiled into another program
+ * instead of building the DFA from the rules file at runtime. The header defines, inside the given namespace:
+ *
+ *   enum class Token_kind      one enumerator per token named by token_kind_names() along with NONE.
+ *   token_name(kind)           the token's name as written in the rules file.
+ *   longest_match(begin, end)  the kind and length of the longest prefix of [begin, end) accepted by the DFA.
+ *
+ * longest_match is direct coded, i.e every state is a label followed by a switch over the byte classes whose cases
+ * jump straight to the next state, and the dead state is replaced by returning the last accepted match.
+ */
+class Scanner_emitter {
+public:
+    static void emit(const DFA &dfa, const std::string &name_space, std::ostream &out);
+
+    /**
+     * Returns the enumerator of every token of the DFA by its id. Token names may be any string, e.g ";" or "if",
+     * so they are prefixed by TK_ and every char that can't appear in an identifier is written as _xHH.
+     */
+    static std::vector<std::string> token_kind_names(const DFA &dfa);
+
+    /**
+     * Turns the given name into a valid C++ identifier, e.g to use a file name as a namespace.
+     */
+    static std::string to_identifier(const std::string &name);
+
+private:
+    static std::string quote(const std::string &s);
+};
+
+
+#endif //COMPILER_SCANNER_EMITTER_H
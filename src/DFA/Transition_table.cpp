@@ -0,0 +1,31 @@
+#include <limits>
+#include "Transition_table.h"
+
+Transition_table::Transition_table(int rows, int columns, const std::vector<int> &cells) : num_rows(rows),
+                                                                                          num_columns(columns) {
+    if (rows <= std::numeric_limits<std::uint8_t>::max() + 1) {
+        pack<std::uint8_t>(cells);
+    } else if (rows <= std::numeric_limits<std::uint16_t>::max() + 1) {
+        pack<std::uint16_t>(cells);
+    } else {
+        pack<std::uint32_t>(cells);
+    }
+}
+
+Transition_table::Transition_table(int rows, int columns, int cell_size, std::shared_ptr<const void> owner,
+                                   const void *cells) : num_rows(rows), num_columns(columns), cell_size(cell_size),
+                                                        owner(std::move(owner)), cells(cells) {}
+
+template<typename T>
+void Transition_table::pack(const std::vector<int> &values) {
+    auto packed = std::make_shared<std::vector<T>>(values.begin(), values.end());
+    cell_size = sizeof(T);
+    cells = packed->data();
+    owner = std::move(packed);
+}
+
+int Transition_table::at(int row, int column) const {
+    return visit([&](const auto *table) {
+        return static_cast<int>(table[row * num_columns + column]);
+    });
+}
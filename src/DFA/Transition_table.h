@@ -0,0 +1,82 @@
+#ifndef COMPILER_TRANSITION_TABLE_H
+#define COMPILER_TRANSITION_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Immutable row-major transition matrix of a DFA, one row per state and one column per input symbol.
+ * Cells are packed using the narrowest unsigned integer type that can hold every state id, so small DFAs
+ * fit in a few cache lines. The storage is shared between copies as the table never changes once built.
+ */
+class Transition_table {
+public:
+    Transition_table() = default;
+
+    /**
+     * Packs the given row-major cells (rows x columns), each cell holding the id of the next state.
+     */
+    Transition_table(int rows, int columns, const std::vector<int> &cells);
+
+    /**
+     * Views cells that are already packed with the given cell size, e.g in a mapped DFA image, without
+     * copying them. The owner keeps the memory pointed to by cells alive as long as the table is used.
+     */
+    Transition_table(int rows, int columns, int cell_size, std::shared_ptr<const void> owner, const void *cells);
+
+    int rows() const {
+        return num_rows;
+    }
+
+    int columns() const {
+        return num_columns;
+    }
+
+    /**
+     * Size in bytes of a single cell i.e 1, 2 or 4.
+     */
+    int entry_size() const {
+        return cell_size;
+    }
+
+    int at(int row, int column) const;
+
+    /**
+     * Returns the packed cells, i.e rows() * columns() * entry_size() bytes.
+     */
+    const void *data() const {
+        return cells;
+    }
+
+    /**
+     * Calls the visitor with a pointer to the first cell typed with the actual cell type (std::uint8_t,
+     * std::uint16_t or std::uint32_t), which lets hot loops be instantiated once per cell width instead of
+     * branching on the width for every lookup.
+     */
+    template<typename Visitor>
+    decltype(auto) visit(Visitor &&visitor) const {
+        switch (cell_size) {
+            case 1:
+                return visitor(reinterpret_cast<const std::uint8_t *>(cells));
+            case 2:
+                return visitor(reinterpret_cast<const std::uint16_t *>(cells));
+            default:
+                return visitor(reinterpret_cast<const std::uint32_t *>(cells));
+        }
+    }
+
+private:
+    int num_rows{};
+    int num_columns{};
+    int cell_size{1};
+    // Keeps the memory pointed to by cells alive.
+    std::shared_ptr<const void> owner;
+    const void *cells{};
+
+    template<typename T>
+    void pack(const std::vector<int> &values);
+};
+
+
+#endif //COMPILER_TRANSITION_TABLE_H
@@ -2,128 +2,118 @@
 // Created by Karim and Hazem on 4/28/2021.
 //
 
+#include <algorithm>
 #include "NFA.h"
 
 
-int NFA::Node::UNIQUE_ID = 0;
-
-NFA::Node::Node() : id(UNIQUE_ID++) {}
-
-int NFA::Node::get_id() const {
-    return id;
+NFA::NFA() : graph(std::make_shared<Graph>()) {
+    start = add_node();
+    end = add_node();
+    addTransition(start, EPSILON, end);
 }
 
-void NFA::Node::addTransition(const char c, Node *ptr) {
-    this->trans[c].push_back(ptr);
+NFA::NFA(const char c) : graph(std::make_shared<Graph>()) {
+    start = add_node();
+    end = add_node();
+    addTransition(start, c, end);
 }
 
-NFA::NFA() {
-    nodes.emplace_back(std::make_unique<Node>());
-    nodes.emplace_back(std::make_unique<Node>());
-    start = nodes[0].get();
-    end = nodes[1].get();
-    start->addTransition(EPSILON, end);
+NFA::NFA(const char lo, const char hi) : graph(std::make_shared<Graph>()) {
+    start = add_node();
+    end = add_node();
+    addTransition(start, lo, hi, end);
 }
 
-NFA::NFA(const char c) {
-    nodes.emplace_back(std::make_unique<Node>());
-    nodes.emplace_back(std::make_unique<Node>());
-    start = nodes[0].get();
-    end = nodes[1].get();
-    start->addTransition(c, end);
+NFA::NFA(int node_count, int start, int end) : start(start), end(end), graph(std::make_shared<Graph>()) {
+    graph->nodes.resize(node_count);
 }
 
-NFA::NFA(NFA::Node *start, NFA::Node *end, std::vector<std::unique_ptr<Node>> nodes) : start(start), end(end),
-                                                                                       nodes(std::move(nodes)) {}
-
-/*
- * Copy constructor in O(n) complexity by traversing the NFA and copying each node/state in it.
- */
-NFA::NFA(const NFA &cpy) {
-    // Check if we have allocated this node or not.
-    std::unordered_map<int, std::unique_ptr<Node>> allocated;
-    // Check if the node has been constructed. By construction we mean adding
-    // its transitions using the old graph.
-    std::unordered_set<int> constructed{cpy.start->id};
-    // Traverse NFA to copy nodes.
-    std::queue<Node *> q;
-    q.push(cpy.start);
-    while (!q.empty()) {
-        Node *cur_old = q.front();
-        q.pop();
-
-        if (auto it = allocated.find(cur_old->id); it == allocated.end()) {
-            allocated[cur_old->id] = std::make_unique<Node>();
-        }
-
-        Node *cur_new = allocated[cur_old->id].get();
-        for (const auto&[c, vec] : cur_old->trans) {
-            for (const auto &node_ptr: vec) {
-
-                if (auto it = allocated.find(node_ptr->id); it == allocated.end()) {
-                    allocated[node_ptr->id] = std::make_unique<Node>();
-                }
-
-                cur_new->trans[c].push_back(allocated[node_ptr->id].get());
-                if (!constructed.count(node_ptr->id)) {
-                    constructed.insert(node_ptr->id);
-                    q.push(node_ptr);
-                }
-            }
-        }
+NFA::NFA(const std::vector<const NFA *> &alternatives, std::vector<int> *accepting_ids)
+        : graph(std::make_shared<Graph>()) {
+    start = end = add_node();
+    accepting_ids->clear();
+    for (const NFA *alternative : alternatives) {
+        const int offset = absorb(*alternative);
+        addTransition(start, EPSILON, offset + alternative->start);
+        accepting_ids->push_back(offset + alternative->end);
     }
-    this->start = allocated[cpy.start->id].get();
-    this->end = allocated[cpy.end->id].get();
+}
 
-    this->nodes.reserve(allocated.size());
-    for (auto &ent : allocated) {
-        this->nodes.emplace_back(std::move(ent.second));
+NFA::Graph &NFA::mutable_graph() {
+    if (graph.use_count() > 1) {
+        graph = std::make_shared<Graph>(*graph);
     }
+    return *graph;
+}
+
+void NFA::addTransition(int from, char c, int to) {
+    addTransition(from, c, c, to);
 }
 
-NFA::NFA(NFA &&rhs) noexcept {
-    this->start = rhs.start;
-    this->end = rhs.end;
-    this->nodes = std::move(rhs.nodes);
+void NFA::addTransition(int from, char lo, char hi, int to) {
+    Graph &g = mutable_graph();
+    g.edges.push_back({static_cast<std::uint32_t>(to), g.nodes[from].first_edge,
+                       static_cast<unsigned char>(lo), static_cast<unsigned char>(hi)});
+    g.nodes[from].first_edge = static_cast<std::uint32_t>(g.edges.size() - 1);
 }
 
-NFA &NFA::operator=(const NFA &cpy) {
-    NFA temp(cpy);
-    this->start = temp.start;
-    this->end = temp.end;
-    this->nodes = std::move(temp.nodes);
-    return *this;
+int NFA::add_node() {
+    Graph &g = mutable_graph();
+    g.nodes.emplace_back();
+    return (int) g.nodes.size() - 1;
 }
 
-NFA &NFA::operator=(NFA &&rhs) noexcept {
-    this->start = rhs.start;
-    this->end = rhs.end;
-    this->nodes = std::move(rhs.nodes);
-    return *this;
+/*
+ * Since nodes and edges refer to each other by index, splicing only needs to shift
+ * the indices of the appended ones.
+ */
+int NFA::absorb(const NFA &rhs) {
+    // rhs may share its graph with this NFA, so it is read through its own pointer after unsharing.
+    Graph &g = mutable_graph();
+    const Graph &other = *rhs.graph;
+    const auto node_offset = static_cast<std::uint32_t>(g.nodes.size());
+    const auto edge_offset = static_cast<std::uint32_t>(g.edges.size());
+    g.nodes.reserve(g.nodes.size() + other.nodes.size());
+    for (const Node &node : other.nodes) {
+        g.nodes.push_back({node.first_edge == NO_EDGE ? NO_EDGE : node.first_edge + edge_offset});
+    }
+    g.edges.reserve(g.edges.size() + other.edges.size());
+    for (const Edge &edge : other.edges) {
+        g.edges.push_back({edge.to + node_offset, edge.next == NO_EDGE ? NO_EDGE : edge.next + edge_offset,
+                           edge.lo, edge.hi});
+    }
+    return static_cast<int>(node_offset);
+}
+
+bool NFA::is_char_class() const {
+    if (size() != 2 || start == end || graph->nodes[end].first_edge != NO_EDGE) {
+        return false;
+    }
+    bool only_chars = true;
+    for_each_edge(start, [&](const Edge &edge) {
+        only_chars = only_chars && !edge.is_epsilon() && (int) edge.to == end;
+    });
+    return only_chars;
 }
 
 /*
- * Compute the ε-closure of the given set by using a bfs that traverses the
+ * Compute the ε-closure of the given set by using a dfs that traverses the
  * edges connected to the current set using ε edges/transitions.
  */
-NFA::Set E_closure(const NFA::Set &states) {
+NFA::Set NFA::E_closure(const NFA::Set &states) const {
     NFA::Set closure = states;
-    std::queue<const NFA::Node *> q;
-    for (auto &state : states) {
-        q.push(state);
-    }
-    while (!q.empty()) {
-        auto front = q.front();
-        q.pop();
-        auto it = front->trans.find(EPSILON);
-        if (it == front->trans.end()) {
-            continue;
-        }
-        for (const auto &child : it->second) {
-            if (closure.insert(child).second) {
-                q.push(child);
+    std::vector<int> stack;
+    states.for_each([&](int id) {
+        stack.push_back(id);
+    });
+    while (!stack.empty()) {
+        const int top = stack.back();
+        stack.pop_back();
+        for_each_edge(top, [&](const Edge &edge) {
+            if (edge.is_epsilon() && closure.insert((int) edge.to)) {
+                stack.push_back((int) edge.to);
             }
-        }
+        });
     }
     return closure;
 }
@@ -133,16 +123,97 @@ NFA::Set E_closure(const NFA::Set &states) {
  * Note that this function doesn't call ε-closure and if needed, follow it by a call to
  * ε-closure.
  */
-NFA::Set Move(const NFA::Set &states, const char c) {
+NFA::Set NFA::Move(const NFA::Set &states, const char c) const {
     NFA::Set new_set;
-    for (auto &state : states) {
-        auto it = state->trans.find(c);
-        if (it == state->trans.end()) {
+    states.for_each([&](int id) {
+        for_each_edge(id, [&](const Edge &edge) {
+            if (edge.accepts(c)) {
+                new_set.insert((int) edge.to);
+            }
+        });
+    });
+    return new_set;
+}
+
+/*
+ * Finds the strongly connected components of the ε edges using an iterative version of Tarjan's algorithm.
+ * Tarjan's algorithm completes a component only after all components reachable from it, so the closures of
+ * the components it points to are always known by the time it is completed.
+ */
+NFA::Closures::Closures(const NFA &nfa) : component(nfa.size(), -1) {
+    const int n = nfa.size();
+    std::vector<std::vector<int>> successors(n);
+    for (int id = 0; id < n; id++) {
+        nfa.for_each_edge(id, [&](const Edge &edge) {
+            if (edge.is_epsilon()) {
+                successors[id].push_back((int) edge.to);
+            }
+        });
+    }
+
+    std::vector<int> index(n, -1), low(n, 0);
+    std::vector<int> stack;
+    std::vector<bool> on_stack(n, false);
+    // Nodes being visited along with the position of the next successor to visit.
+    std::vector<std::pair<int, int>> visiting;
+    int next_index = 0;
+    auto visit = [&](int id) {
+        index[id] = low[id] = next_index++;
+        stack.push_back(id);
+        on_stack[id] = true;
+        visiting.emplace_back(id, 0);
+    };
+    for (int root = 0; root < n; root++) {
+        if (index[root] != -1) {
             continue;
         }
-        for (const auto &child : it->second) {
-            new_set.insert(child);
+        visit(root);
+        while (!visiting.empty()) {
+            const int id = visiting.back().first;
+            const int position = visiting.back().second++;
+            if (position < (int) successors[id].size()) {
+                const int child = successors[id][position];
+                if (index[child] == -1) {
+                    visit(child);
+                } else if (on_stack[child]) {
+                    low[id] = std::min(low[id], index[child]);
+                }
+                continue;
+            }
+            visiting.pop_back();
+            if (!visiting.empty()) {
+                low[visiting.back().first] = std::min(low[visiting.back().first], low[id]);
+            }
+            if (low[id] != index[id]) {
+                continue;
+            }
+            // id is the root of a component, its members are on top of the stack.
+            const int current = (int) closures.size();
+            std::vector<int> members;
+            Set closure;
+            do {
+                members.push_back(stack.back());
+                stack.pop_back();
+                on_stack[members.back()] = false;
+                component[members.back()] = current;
+                closure.insert(members.back());
+            } while (members.back() != id);
+            for (int member : members) {
+                for (int child : successors[member]) {
+                    if (component[child] != current) {
+                        closure |= closures[component[child]];
+                    }
+                }
+            }
+            closures.push_back(std::move(closure));
         }
     }
-    return new_set;
+}
+
+NFA::Set NFA::Closures::of(const NFA::Set &states) const {
+    NFA::Set closure;
+    states.for_each([&](int id) {
+        closure |= closures[component[id]];
+    });
+    return closure;
 }
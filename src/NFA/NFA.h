@@ -5,6 +5,7 @@
 #ifndef COMPILER_NFA_H
 #define COMPILER_NFA_H
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -12,6 +13,8 @@
 #include <unordered_set>
 #include <set>
 
+#include "State_set.h"
+
 const char EPSILON = 0;
 
 // Non-deterministic automata class for string matching.
@@ -29,97 +32,170 @@ public:
      */
     explicit NFA(char c);
 
-    class Node;
-
     /**
-     * Constructs an NFA given the start and ending pointers of the NFA.
-     * Note that the end state is considered to be the accepting state.
+     * Constructs an NFA that accepts a string consisting of a single char in the inclusive range [lo, hi]
+     * using a single edge.
      */
-    explicit NFA(Node* start, Node* end, std::vector<std::unique_ptr<Node>> nodes);
-
-    NFA(const NFA &cpy);
-
-    NFA &operator=(const NFA &cpy);
+    NFA(char lo, char hi);
 
-    NFA(NFA &&rhs) noexcept;
+    /**
+     * Constructs an NFA of the given number of nodes without any transitions, nodes are
+     * given ids from 0 to node_count - 1. Note that the end state is considered to be the
+     * accepting state.
+     */
+    NFA(int node_count, int start, int end);
 
-    NFA &operator=(NFA &&rhs) noexcept;
+    /**
+     * Constructs an NFA whose start state is connected by ε edges to copies of the given NFAs, their accepting
+     * states are kept apart instead of being merged into a single end state. The id of the accepting state of
+     * alternatives[i] in the constructed NFA is stored in accepting_ids[i].
+     */
+    NFA(const std::vector<const NFA *> &alternatives, std::vector<int> *accepting_ids);
 
     /**
-     * Simple set of Nodes/States of the NFA which we define operations such as
+     * Set of Nodes/States of the NFA given by their ids, which we define operations such as
      * Move, E_closure on, see below.
      */
-    using Set = std::unordered_set<const NFA::Node *>;
+    using Set = State_set;
 
-    class Node {
-    public:
-        using Transitions = std::unordered_map<char, std::vector<Node*>>;
-        static int UNIQUE_ID;
+    // Marks the end of the list of edges leaving a node.
+    static constexpr std::uint32_t NO_EDGE = UINT32_MAX;
 
-        Node();
+    /**
+     * Edges leaving a node form a singly linked list inside the NFA's edge storage, which keeps
+     * all edges in one contiguous vector instead of a container per node. An edge is labelled by
+     * an inclusive range of chars, so a whole range such as a-z is a single edge.
+     */
+    struct Edge {
+        // Id of the node this edge leads to.
+        std::uint32_t to;
+        // Index of the next edge leaving the same node, or NO_EDGE.
+        std::uint32_t next;
+        // Range of the chars labelling this edge compared as unsigned bytes, both are EPSILON for ε edges.
+        unsigned char lo, hi;
+
+        bool is_epsilon() const {
+            return hi == static_cast<unsigned char>(EPSILON);
+        }
 
-        int get_id() const;
+        bool accepts(char c) const {
+            const auto byte = static_cast<unsigned char>(c);
+            return lo <= byte && byte <= hi;
+        }
+    };
 
-        void addTransition(char c, Node* ptr);
+    struct Node {
+        // Index of the first edge leaving this node, or NO_EDGE.
+        std::uint32_t first_edge = NO_EDGE;
+    };
 
-        friend class NFA;
+    /**
+     * Nodes and edges of an NFA. Copies of an NFA share the same graph, which is only cloned once
+     * one of them is modified. Hence, copying an NFA, e.g to reference a regular definition, is O(1).
+     */
+    struct Graph {
+        // Every node is stored at the index given by its id.
+        std::vector<Node> nodes;
+        std::vector<Edge> edges;
+    };
 
-        friend class NFA_Builder;
+    /**
+     * The ε-closures of every node of an NFA, computed once by condensing the ε edges into strongly connected
+     * components. All nodes of a component share the same closure, which is the component itself along with the
+     * closures of the components it points to. The ε-closure of a set then becomes a union of these closures.
+     */
+    class Closures {
+    public:
+        explicit Closures(const NFA &nfa);
 
-        friend NFA::Set E_closure(const NFA::Set &states);
+        const Set &of(int id) const {
+            return closures[component[id]];
+        }
 
-        friend NFA::Set Move(const NFA::Set &states, const char c);
+        /**
+         * Returns the ε-closure of the given set, i.e the same as NFA::E_closure but without any traversal.
+         */
+        Set of(const Set &states) const;
 
     private:
-        const int id;
-        Transitions trans;
+        // Strongly connected component of every node by its id.
+        std::vector<int> component;
+        // ε-closure of every component.
+        std::vector<Set> closures;
     };
 
     friend class NFA_Builder;
 
-    const Node *get_start() const {
+    int get_start() const {
         return start;
     }
 
-    const Node *get_end() const {
+    int get_end() const {
         return end;
     }
 
+    int size() const {
+        return (int) graph->nodes.size();
+    }
+
+    void addTransition(int from, char c, int to);
+
+    /**
+     * Adds a single edge accepting every char in the inclusive range [lo, hi].
+     */
+    void addTransition(int from, char lo, char hi, int to);
+
+    /**
+     * Calls the given function with every edge leaving the given node.
+     */
+    template<typename Function>
+    void for_each_edge(int id, Function &&function) const {
+        const std::vector<Edge> &edges = graph->edges;
+        for (std::uint32_t e = graph->nodes[id].first_edge; e != NO_EDGE; e = edges[e].next) {
+            function(edges[e]);
+        }
+    }
+
+    /**
+     * Given a set of Nodes/States of the NFA, It returns ε-closure of that set
+     * i.e adds to the set all the states that are connected to this set of states
+     * with ε edges.
+     */
+    Set E_closure(const Set &states) const;
+
+    /**
+     * Given a set of Nodes/States of the NFA, it moves every state in this set
+     * according to the transition character c. Note that this function doesn't call
+     * ε-closure after moving the state. If needed, follow it by a call to ε-closure.
+     */
+    Set Move(const Set &states, char c) const;
+
 private:
     // Start and end states of the automata respectively. Note that
     // the end state is considered to be the accepting state,
     // as any NFA has a single accepting state.
-    Node *start, *end;
-    std::vector<std::unique_ptr<Node>> nodes;
+    int start, end;
+    std::shared_ptr<Graph> graph;
 
-};
+    /**
+     * Returns the graph to be modified, cloning it first if it is shared with other NFAs.
+     */
+    Graph &mutable_graph();
 
-namespace std
-{
-    template<>struct hash<NFA::Set>{
-        size_t operator() (const NFA::Set& st) const noexcept {
-            size_t res = 0;
-            auto op = hash<NFA::Set::value_type>{};
-            for(const auto& elem: st){
-                res ^= op(elem);
-            }
-            return res;
-        }
-    };
-}
-
-/**
- * Given a set of Nodes/States of the NFA, It returns ε-closure of that set
- * i.e adds to the set all the states that are connected to this set of states
- * with ε edges.
- */
-NFA::Set E_closure(const NFA::Set &states);
-
-/**
- * Given a set of Nodes/States of the NFA, it moves every state in this set
- * according to the transition character c. Note that this function doesn't call
- * ε-closure after moving the state. If needed, follow it by a call to ε-closure.
- */
-NFA::Set Move(const NFA::Set &states, char c);
+    int add_node();
+
+    /**
+     * Returns true if the NFA is just a start and an end node connected by non-ε edges, i.e it
+     * accepts exactly the single chars labelling these edges.
+     */
+    bool is_char_class() const;
+
+    /**
+     * Appends copies of all nodes and edges of rhs to this NFA and returns the offset added to the ids
+     * of rhs nodes, i.e node i of rhs becomes node offset + i.
+     */
+    int absorb(const NFA &rhs);
+
+};
 
 #endif //COMPILER_NFA_H
@@ -13,10 +13,9 @@ NFA_Builder::NFA_Builder(const NFA &nfa) : nfa(nfa) {
 }
 
 NFA_Builder &NFA_Builder::Concatenate(NFA rhs) {
-    nfa.end->addTransition(EPSILON, rhs.start);
-    nfa.end = rhs.end;
-    nfa.nodes.insert(nfa.nodes.end(), std::make_move_iterator(rhs.nodes.begin()),
-              std::make_move_iterator(rhs.nodes.end()));
+    const int offset = nfa.absorb(rhs);
+    nfa.addTransition(nfa.end, EPSILON, offset + rhs.start);
+    nfa.end = offset + rhs.end;
     return *this;
 }
 
@@ -25,19 +24,24 @@ NFA_Builder &NFA_Builder::Concatenate(const char c) {
 }
 
 NFA_Builder &NFA_Builder::Or(NFA rhs) {
-    nfa.nodes.push_back(std::make_unique<NFA::Node>());
-    auto new_start = nfa.nodes.back().get();
-    nfa.nodes.push_back(std::make_unique<NFA::Node>());
-    auto new_end = nfa.nodes.back().get();
+    // The union of two char classes is a char class as well, so the edges of rhs are
+    // simply added next to the existing ones instead of adding ε edges and new nodes.
+    if (nfa.is_char_class() && rhs.is_char_class()) {
+        rhs.for_each_edge(rhs.start, [&](const NFA::Edge &edge) {
+            nfa.addTransition(nfa.start, static_cast<char>(edge.lo), static_cast<char>(edge.hi), nfa.end);
+        });
+        return *this;
+    }
+    const int offset = nfa.absorb(rhs);
+    const int new_start = nfa.add_node();
+    const int new_end = nfa.add_node();
 
-    new_start->addTransition(EPSILON, nfa.start);
-    new_start->addTransition(EPSILON, rhs.start);
-    nfa.end->addTransition(EPSILON, new_end);
-    rhs.end->addTransition(EPSILON, new_end);
+    nfa.addTransition(new_start, EPSILON, nfa.start);
+    nfa.addTransition(new_start, EPSILON, offset + rhs.start);
+    nfa.addTransition(nfa.end, EPSILON, new_end);
+    nfa.addTransition(offset + rhs.end, EPSILON, new_end);
     nfa.start = new_start;
     nfa.end = new_end;
-    nfa.nodes.insert(nfa.nodes.end(), std::make_move_iterator(rhs.nodes.begin()),
-                     std::make_move_iterator(rhs.nodes.end()));
     return *this;
 }
 
@@ -46,14 +50,12 @@ NFA_Builder &NFA_Builder::Or(const char c) {
 }
 
 NFA_Builder &NFA_Builder::Positive_closure() {
-    nfa.nodes.push_back(std::make_unique<NFA::Node>());
-    auto new_start = nfa.nodes.back().get();
-    nfa.nodes.push_back(std::make_unique<NFA::Node>());
-    auto new_end = nfa.nodes.back().get();
+    const int new_start = nfa.add_node();
+    const int new_end = nfa.add_node();
 
-    nfa.end->addTransition(EPSILON, nfa.start);
-    new_start->addTransition(EPSILON, nfa.start);
-    nfa.end->addTransition(EPSILON, new_end);
+    nfa.addTransition(nfa.end, EPSILON, nfa.start);
+    nfa.addTransition(new_start, EPSILON, nfa.start);
+    nfa.addTransition(nfa.end, EPSILON, new_end);
     nfa.start = new_start;
     nfa.end = new_end;
     return *this;
@@ -61,7 +63,7 @@ NFA_Builder &NFA_Builder::Positive_closure() {
 
 NFA_Builder &NFA_Builder::Kleene_closure() {
     this->Positive_closure();
-    nfa.start->addTransition(EPSILON, nfa.end);
+    nfa.addTransition(nfa.start, EPSILON, nfa.end);
     return *this;
 }
 
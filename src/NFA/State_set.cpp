@@ -0,0 +1,75 @@
+#include "State_set.h"
+
+namespace {
+    // Finalizer of splitmix64, it spreads every input bit over the whole word.
+    std::uint64_t mix(std::uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+}
+
+State_set::State_set(std::initializer_list<int> ids) {
+    for (int id : ids) {
+        insert(id);
+    }
+}
+
+bool State_set::insert(int id) {
+    const std::size_t index = id / WORD_BITS;
+    const std::uint64_t bit = std::uint64_t{1} << (id % WORD_BITS);
+    if (index >= words.size()) {
+        words.resize(index + 1, 0);
+    }
+    if (words[index] & bit) {
+        return false;
+    }
+    words[index] |= bit;
+    return true;
+}
+
+std::size_t State_set::count(int id) const {
+    const std::size_t index = id / WORD_BITS;
+    return index < words.size() && (words[index] >> (id % WORD_BITS) & 1);
+}
+
+bool State_set::empty() const {
+    return words.empty();
+}
+
+std::size_t State_set::size() const {
+    std::size_t size = 0;
+    for (std::uint64_t word : words) {
+        size += __builtin_popcountll(word);
+    }
+    return size;
+}
+
+State_set &State_set::operator|=(const State_set &rhs) {
+    if (rhs.words.size() > words.size()) {
+        words.resize(rhs.words.size(), 0);
+    }
+    for (std::size_t i = 0; i < rhs.words.size(); i++) {
+        words[i] |= rhs.words[i];
+    }
+    return *this;
+}
+
+bool State_set::operator==(const State_set &rhs) const {
+    return words == rhs.words;
+}
+
+bool State_set::operator!=(const State_set &rhs) const {
+    return words != rhs.words;
+}
+
+std::uint64_t State_set::hash() const {
+    std::uint64_t hash = mix(words.size());
+    for (std::uint64_t word : words) {
+        hash = mix(hash ^ mix(word)) + 0x9e3779b97f4a7c15ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,73 @@
+#ifndef COMPILER_STATE_SET_H
+#define COMPILER_STATE_SET_H
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+/**
+ * Dense set of NFA node ids stored as a dynamic bitset. The words never end with a zero word, so equal sets
+ * always have equal representations, which keeps equality and hashing a plain pass over the words.
+ */
+class State_set {
+public:
+    State_set() = default;
+
+    State_set(std::initializer_list<int> ids);
+
+    /**
+     * Inserts the given id and returns true if it wasn't already in the set.
+     */
+    bool insert(int id);
+
+    std::size_t count(int id) const;
+
+    bool empty() const;
+
+    std::size_t size() const;
+
+    /**
+     * Inserts every id of rhs into the set.
+     */
+    State_set &operator|=(const State_set &rhs);
+
+    bool operator==(const State_set &rhs) const;
+
+    bool operator!=(const State_set &rhs) const;
+
+    /**
+     * Calls the given function with every id in the set in increasing order.
+     */
+    template<typename Function>
+    void for_each(Function &&function) const {
+        for (std::size_t i = 0; i < words.size(); i++) {
+            std::uint64_t word = words[i];
+            while (word) {
+                function(static_cast<int>(i * WORD_BITS + __builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+
+    /**
+     * Strong 64-bit hash of the set's content.
+     */
+    std::uint64_t hash() const;
+
+private:
+    static constexpr int WORD_BITS = 64;
+
+    std::vector<std::uint64_t> words;
+};
+
+namespace std {
+    template<>
+    struct hash<State_set> {
+        size_t operator()(const State_set &set) const noexcept {
+            return static_cast<size_t>(set.hash());
+        }
+    };
+}
+
+#endif //COMPILER_STATE_SET_H
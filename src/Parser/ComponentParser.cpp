@@ -74,9 +74,11 @@ NFA ComponentParser::SingleRegDefToNFA(const std::vector<component>& components)
             NFABuilders.push(addExpressionInBrackets(components, &i));
         }
         else if (comp.type == REG_EXP || comp.type == RED_DEF) {
-            if (regToNFA.find(comp.regularDefinition) == regToNFA.end())
+            auto it = regToNFA.find(comp.regularDefinition);
+            if (it == regToNFA.end())
                 throw logic_error(comp.regularDefinition + " Was not parsed.");
-            NFABuilders.push(NFA_Builder(regToNFA[comp.regularDefinition]));
+            // Shares the definition's graph, it is only copied once the builder modifies it.
+            NFABuilders.push(NFA_Builder(it->second));
         }
         // Apply a binary operation based on the precedence.
         else if (comp.type == CONCAT || comp.type == OR) {
@@ -144,11 +146,8 @@ NFA_Builder ComponentParser::applyToOperation(const component& c1, const compone
     char first = c1.regularDefinition[0];
     char second = c2.regularDefinition[0];
     if (second - first < 0) throw logic_error("Check '-' syntax, eg: You can use a-z not z-a.");
-    NFA_Builder nfa_builder((NFA(first)));
-    while (++first <= second) {
-        nfa_builder.Or(NFA (first));
-    }
-    return std::move(nfa_builder);
+    // The whole range is accepted by a single edge.
+    return NFA_Builder(NFA(first, second));
 }
 
 
@@ -2,15 +2,34 @@
 // Created by Abd Elkader on 5/1/2021.
 //
 
-#include <iterator>
-#include <sstream>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <thread>
 
 #include "LexicalParser.h"
 #include "InputParser.h"
 #include "ComponentParser.h"
+#include "../DFA/DFA_image.h"
 
-LexicalParser::LexicalParser(const std::string &inputFilePath) : dfa(parse(inputFilePath)) {}
+LexicalParser::LexicalParser(const std::string &inputFilePath)
+        : dfa(parse(inputFilePath)), selfLoops(find_self_loops(dfa)) {}
+
+LexicalParser::LexicalParser(const std::string &rulesFilePath, const std::string &dfaImagePath)
+        : dfa(load_or_parse(rulesFilePath, dfaImagePath)), selfLoops(find_self_loops(dfa)) {}
+
+DFA LexicalParser::load_or_parse(const std::string &rulesFilePath, const std::string &dfaImagePath) {
+    const std::uint64_t rulesHash = DFA_image::hash_file(rulesFilePath);
+    std::optional<DFA> image = DFA_image::load(dfaImagePath, rulesHash, &this->grammar_parsing_error);
+    if (image) {
+        return std::move(*image);
+    }
+    DFA dfa = parse(rulesFilePath);
+    if (!DFA_image::write(dfaImagePath, dfa, rulesHash, this->grammar_parsing_error)) {
+        std::cerr << "Warning: Couldn't write the DFA image to " << dfaImagePath << "\n";
+    }
+    return dfa;
+}
 
 /**
  * Coverts Grammar rules stored in a file to Deterministic State Automaton object.
@@ -48,9 +67,75 @@ DFA LexicalParser::parse(const std::string &inputFilePath) {
     return DFA(results);
 }
 
+/**
+ * Finds the bytes on which every state transitions to itself, e.g letters and digits once an identifier started.
+ * Whitespaces end tokens, so they are never part of a run. A run of such bytes is then consumed at once by
+ * SimdScan instead of walking the DFA for each byte.
+ */
+std::vector<ByteRanges> LexicalParser::find_self_loops(const DFA &dfa) {
+    std::vector<ByteRanges> selfLoops(dfa.size());
+    for (int state = 0; state < dfa.size(); state++) {
+        if (state == dfa.getDeadState()) {
+            continue;
+        }
+        std::bitset<DFA::BYTE_VALUES> bytes;
+        for (int c = 0; c < DFA::BYTE_VALUES; c++) {
+            bytes[c] = !SimdScan::SPACES.contains(c) && dfa.next(state, static_cast<char>(c)) == state;
+        }
+        SimdScan::to_ranges(bytes, selfLoops[state]);
+    }
+    return selfLoops;
+}
+
+/**
+ * Maps the whole program file, tokens are then scanned directly from its bytes.
+ */
 void LexicalParser::set_input_stream(const std::string &input_stream) {
-    this->file_stream.open(input_stream, std::ios::in);
-    this->line_number = 0;
+    this->input = std::make_unique<MappedFile>(input_stream);
+    this->stream = nullptr;
+    this->window.clear();
+    this->tokenBuffer.clear();
+    this->scanned.clear();
+    this->cursor = this->input_begin = this->input->data();
+    this->input_end = this->input->data() + this->input->size();
+    this->input_begin_offset = 0;
+    this->lineStarts.assign(1, 0);
+    this->droppedLines = 0;
+    this->poppedOffset = 0;
+}
+
+void LexicalParser::set_input_stream(std::istream &input_stream) {
+    this->input.reset();
+    this->stream = &input_stream;
+    this->window.clear();
+    this->tokenBuffer.clear();
+    this->scanned.clear();
+    this->cursor = this->input_end = this->input_begin = nullptr;
+    this->input_begin_offset = 0;
+    this->lineStarts.assign(1, 0);
+    this->droppedLines = 0;
+    this->poppedOffset = 0;
+}
+
+void LexicalParser::set_input_stream(const std::string &input_stream, unsigned threads, Split split) {
+    set_input_stream(input_stream);
+    const char *begin = this->cursor;
+    const std::size_t size = this->input_end - begin;
+    const std::size_t chunk_count = std::max<std::size_t>(1, std::min<std::size_t>(threads, size / MIN_PARALLEL_CHUNK));
+    std::vector<const char *> splits{begin};
+    for (std::size_t i = 1; i < chunk_count; i++) {
+        const char *at = std::max(splits.back(), begin + size / chunk_count * i);
+        if (split == Split::LINES) {
+            const void *newline = std::memchr(at, '\n', this->input_end - at);
+            at = newline == nullptr ? this->input_end : static_cast<const char *>(newline) + 1;
+        }
+        splits.push_back(at);
+    }
+    splits.push_back(this->input_end);
+    scan_parallel(splits);
+    this->scannedNext = 0;
+    // Everything was scanned, so tokens are only taken from scanned.
+    this->cursor = this->input_end;
 }
 
 /**
@@ -60,13 +145,37 @@ bool LexicalParser::has_grammar_error() const {
     return this->grammar_parsing_error;
 }
 
+const DFA &LexicalParser::get_DFA() const {
+    return this->dfa;
+}
+
+const std::vector<std::string> &LexicalParser::get_token_names() const {
+    return this->dfa.getTokenNames();
+}
+
+std::size_t LexicalParser::stream_buffer_size() const {
+    return this->window.size();
+}
+
 /**
  * If there's a token, it will be assign it to token parameter then return true,
  * Otherwise return false.
  */
 bool LexicalParser::get_token(Token &token) {
-    // Make sure that there are more tokens to get.
-    if (tokenBuffer.empty() && !get_next_line()) {
+    Compact_token compact{};
+    if (!get_token(compact)) {
+        return false;
+    }
+    token = {get_token_names()[compact.kind], std::string(compact.lexeme), compact.offset};
+    return true;
+}
+
+/**
+ * Same as above but without copying the token's name and lexeme.
+ */
+bool LexicalParser::get_token(Compact_token &token) {
+    // Make sure that there are more tokens to get, scanning a whole batch so that the scanner's tables stay hot.
+    if (tokenBuffer.empty() && !scan_tokens(TOKEN_BATCH)) {
         return false;
     }
     token = tokenBuffer.front();
@@ -78,63 +187,302 @@ bool LexicalParser::get_token(Token &token) {
  */
 void LexicalParser::next_token() {
     if(!tokenBuffer.empty()){
-        tokenBuffer.pop();
+        poppedOffset = tokenBuffer.front().offset;
+        tokenBuffer.pop_front();
+    }
+}
+
+std::size_t LexicalParser::fill(std::size_t n) {
+    return scan_tokens(std::min(n, TOKEN_RING_CAPACITY));
+}
+
+bool LexicalParser::peek(std::size_t k, Compact_token &token) {
+    if (k >= TOKEN_RING_CAPACITY || scan_tokens(k + 1) <= k) {
+        return false;
+    }
+    token = tokenBuffer[k];
+    return true;
+}
+
+namespace {
+    bool is_space(char c) {
+        return SimdScan::SPACES.contains(static_cast<unsigned char>(c));
+    }
+}
+
+/**
+ * Reads the next chunk of the input stream after input_end. The lexemes of the buffered tokens are packed at the
+ * start of the window followed by the bytes from the cursor on, so the whitespaces between tokens are dropped and
+ * the window only holds the buffered lexemes, the token being matched and a chunk. Returns false if there's no
+ * more input.
+ */
+bool LexicalParser::read_chunk() {
+    if (this->stream == nullptr || !*this->stream) {
+        return false;
+    }
+    drop_popped_lines();
+    std::size_t kept = this->input_end - this->cursor;
+    for (std::size_t i = 0; i < this->tokenBuffer.size(); i++) {
+        kept += this->tokenBuffer[i].lexeme.size();
+    }
+    std::vector<char> grown;
+    if (this->window.size() < kept + CHUNK_SIZE) {
+        grown.resize(std::max(kept + CHUNK_SIZE, 2 * this->window.size()));
+    }
+    char *base = grown.empty() ? this->window.data() : grown.data();
+    // Bytes only move towards the start of the window, so packing it in place never overwrites bytes still to move.
+    char *packed = base;
+    for (std::size_t i = 0; i < this->tokenBuffer.size(); i++) {
+        std::string_view &lexeme = this->tokenBuffer[i].lexeme;
+        std::memmove(packed, lexeme.data(), lexeme.size());
+        lexeme = std::string_view(packed, lexeme.size());
+        packed += lexeme.size();
+    }
+    // Buffered tokens already have their offsets, so offsets are only needed from the cursor on.
+    this->input_begin_offset += this->cursor - this->input_begin;
+    if (this->cursor != this->input_end) {
+        std::memmove(packed, this->cursor, this->input_end - this->cursor);
     }
+    this->cursor = this->input_begin = packed;
+    if (!grown.empty()) {
+        this->window.swap(grown);
+    }
+    this->stream->read(base + kept, static_cast<std::streamsize>(this->window.size() - kept));
+    this->input_end = base + kept + this->stream->gcount();
+    return this->stream->gcount() > 0;
 }
 
 /**
- * Tries to get and store more tokens in tokenBuffer.
- * return 0 if no tokens found, number of tokens otherwise.
+ * Tries to get and store more tokens in tokenBuffer until it holds n tokens, tokens are separated by whitespaces
+ * or follow each other directly. n must not exceed TOKEN_RING_CAPACITY. Returns the number of buffered tokens,
+ * which is less than n only if the end of the input was reached.
  */
-int LexicalParser::get_next_line() {
-    // Make sure that there's an open file to read from.
-    if (!this->file_stream.is_open()) {
-        return 0;
+std::size_t LexicalParser::scan_tokens(std::size_t n) {
+    while (this->tokenBuffer.size() < n && this->scannedNext < this->scanned.size()) {
+        this->tokenBuffer.push_back(this->scanned[this->scannedNext++]);
     }
-    std::string line;
-    if (getline(this->file_stream, line)) {
-        line_number++;
-        // Split the line by whitespaces and store all words in a vector.
-        std::istringstream iss(line);
-        std::vector<std::string> words{std::istream_iterator<std::string>{iss},
-                                       std::istream_iterator<std::string>{}};
-        for (const auto &word: words) {
-            performMaximalMunch(word);
+    while (this->tokenBuffer.size() < n) {
+        // Skip the whitespaces before the next token.
+        while (true) {
+            if (this->cursor == this->input_end && !read_chunk()) {
+                return this->tokenBuffer.size();
+            }
+            const char *spaces = this->cursor;
+            this->cursor = SimdScan::skip_run(this->cursor, this->input_end, SimdScan::SPACES);
+            find_line_starts(spaces, this->cursor, this->lineStarts);
+            if (this->cursor != this->input_end) {
+                break;
+            }
         }
+        performMaximalMunch();
     }
     return this->tokenBuffer.size();
 }
 
-void LexicalParser::performMaximalMunch(const std::string &word) {
-    if (word.empty()) return;
-
-    int lastAcceptingState = -1;
-    int lastAcceptingIndex = -1;
-    int index = 0;
-
-    const std::vector<DFA::State> &states = this->dfa.getStates();
-    while (index < word.length()) {
-        // Assuming that initial state is 0
-        const DFA::State *state = &states.at(0);
-        for (int i = index; i < word.length(); i++) {
-            state = &states.at(state->transitions.at(word[i]));
-            if (state->isAcceptingState) {
+/**
+ * Walks the DFA over the bytes of a token starting at begin, resuming where munch stopped. It stops once no longer
+ * token can be matched, i.e on the dead state or a whitespace, or at end where more input may continue the token.
+ * The matched bytes are addressed relative to begin since reading a chunk may move them.
+ */
+void LexicalParser::continue_munch(Munch &munch, const char *begin, const char *end) const {
+    const int columns = this->dfa.getTable().columns();
+    const std::array<std::uint8_t, DFA::BYTE_VALUES> &charClasses = this->dfa.getCharClasses();
+    const std::vector<int> &accepting = this->dfa.getAcceptingTokens();
+    const int deadState = this->dfa.getDeadState();
+    this->dfa.getTable().visit([&](const auto *table) {
+        while (begin + munch.length != end) {
+            const char c = begin[munch.length];
+            if (munch.state == deadState || is_space(c)) {
+                munch.stopped = true;
+                return;
+            }
+            munch.state = table[munch.state * columns + charClasses[static_cast<unsigned char>(c)]];
+            munch.length++;
+            // Bytes keeping the DFA in the same state are consumed at once.
+            const char *run = begin + munch.length;
+            munch.length += SimdScan::skip_run(run, end, this->selfLoops[munch.state]) - run;
+            if (accepting[munch.state] != DFA::NOT_ACCEPTING) {
                 // To keep track of the last Accepting state.
-                lastAcceptingIndex = i;
-                lastAcceptingState = state->id;
+                munch.lastAcceptingLength = munch.length;
+                munch.lastAcceptingState = munch.state;
             }
         }
-        if (lastAcceptingIndex < index) {
-            // Error Recovery: In the panic mode, the successive characters are always ignored until
-            // we reach a well-formed token.
-            std::cerr << "Error in line " << line_number << " :" << word.substr(index) << " Couldn't match\n";
-            index++;
-            continue;
+        munch.stopped = munch.state == deadState;
+    });
+}
+
+/**
+ * Returns the longest token found by a stopped munch at begin, or a token of kind NOT_ACCEPTING viewing the word
+ * at begin if there's none.
+ */
+Compact_token LexicalParser::unmatched_or_token(const Munch &munch, const char *begin, const char *end) const {
+    if (munch.lastAcceptingState == -1) {
+        const char *word_end = begin;
+        while (word_end != end && !is_space(*word_end)) {
+            word_end++;
+        }
+        return {DFA::NOT_ACCEPTING, offset_of(begin), std::string_view(begin, word_end - begin)};
+    }
+    return {this->dfa.getToken(munch.lastAcceptingState), offset_of(begin),
+            std::string_view(begin, munch.lastAcceptingLength)};
+}
+
+std::uint64_t LexicalParser::offset_of(const char *p) const {
+    return this->input_begin_offset + (p - this->input_begin);
+}
+
+/**
+ * Appends the offset of the byte after every newline in [begin, end).
+ */
+void LexicalParser::find_line_starts(const char *begin, const char *end, std::vector<std::uint64_t> &starts) const {
+    for (const char *p = begin; p != end; p++) {
+        p = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (p == nullptr) {
+            break;
+        }
+        starts.push_back(offset_of(p) + 1);
+    }
+}
+
+/**
+ * Drops the lines before the one of the last popped token, which can no longer be located, so that the line index
+ * of a streamed program doesn't grow with its size.
+ */
+void LexicalParser::drop_popped_lines() {
+    const auto line = std::prev(std::upper_bound(this->lineStarts.begin(), this->lineStarts.end(), this->poppedOffset));
+    this->droppedLines += line - this->lineStarts.begin();
+    this->lineStarts.erase(this->lineStarts.begin(), line);
+}
+
+Source_location LexicalParser::get_location(std::uint64_t offset) const {
+    const auto line = std::upper_bound(this->lineStarts.begin(), this->lineStarts.end(), offset);
+    return {static_cast<int>(this->droppedLines + (line - this->lineStarts.begin())),
+            static_cast<int>(offset - *std::prev(line)) + 1};
+}
+
+void LexicalParser::report_unmatched(int line, std::string_view word) {
+    std::cerr << "Error in line " << line << " :" << word << " Couldn't match\n";
+}
+
+/**
+ * Matches the longest token starting at the cursor, or skips a single char if no token starts there.
+ */
+void LexicalParser::performMaximalMunch() {
+    Munch munch;
+    do {
+        continue_munch(munch, this->cursor, this->input_end);
+    } while (!munch.stopped && read_chunk());
+    const Compact_token token = unmatched_or_token(munch, this->cursor, this->input_end);
+    if (token.kind == DFA::NOT_ACCEPTING) {
+        // Error Recovery: In the panic mode, the successive characters are always ignored until
+        // we reach a well-formed token.
+        report_unmatched(static_cast<int>(this->droppedLines + this->lineStarts.size()), token.lexeme);
+        this->cursor++;
+        return;
+    }
+    this->tokenBuffer.push_back(token);
+    this->cursor += token.lexeme.size();
+}
+
+/**
+ * Scans every token starting in [begin, chunk_end), the last one may end after chunk_end. Unmatched words are
+ * kept as tokens of kind NOT_ACCEPTING along with the newlines from begin to them.
+ */
+void LexicalParser::scan_chunk(const char *begin, const char *chunk_end, Chunk_scan &chunk) const {
+    const char *p = begin;
+    chunk.newlines = 0;
+    while (true) {
+        p = SimdScan::skip_spaces(p, this->input_end, chunk.newlines);
+        if (p >= chunk_end) {
+            break;
+        }
+        Munch munch;
+        continue_munch(munch, p, this->input_end);
+        const Compact_token step = unmatched_or_token(munch, p, this->input_end);
+        if (step.kind == DFA::NOT_ACCEPTING) {
+            chunk.errors.emplace_back(chunk.steps.size(), chunk.newlines);
+            p++;
+        } else {
+            p += step.lexeme.size();
         }
-        // Store word[index... lastAcceptingIndex] as a token whose state_id is lastAcceptingState.
-        this->tokenBuffer.push({states.at(lastAcceptingState).regEXP,
-                                word.substr(index, lastAcceptingIndex - index + 1)});
-        index = lastAcceptingIndex + 1;
+        chunk.steps.push_back(step);
     }
+    chunk.stop = p;
 }
 
+/**
+ * Scans every chunk on its own thread, then concatenates their tokens into scanned. A chunk's scan is only valid
+ * from the first position the sequential scan also reaches, so tokens are rescanned from where the previous chunk
+ * stopped until reaching one of the chunk's tokens. Chunks starting right after a newline never need rescanning.
+ */
+void LexicalParser::scan_parallel(const std::vector<const char *> &splits) {
+    const std::size_t chunk_count = splits.size() - 1;
+    std::vector<Chunk_scan> chunks(chunk_count);
+    // Lines starting in (splits[i], splits[i + 1]], to know the line each chunk starts at.
+    std::vector<std::vector<std::uint64_t>> split_lines(chunk_count);
+    auto work = [&](std::size_t i) {
+        scan_chunk(splits[i], splits[i + 1], chunks[i]);
+        find_line_starts(splits[i], splits[i + 1], split_lines[i]);
+    };
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < chunk_count; i++) {
+        workers.emplace_back(work, i);
+    }
+    work(0);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+
+    this->scanned.clear();
+    const char *pos = splits[0];
+    int line = 1, chunk_line = 1;
+    for (std::size_t i = 0; i < chunk_count; chunk_line += static_cast<int>(split_lines[i].size()), i++) {
+        const Chunk_scan &chunk = chunks[i];
+        std::size_t first = 0;
+        if (pos != splits[i]) {
+            while (true) {
+                pos = SimdScan::skip_spaces(pos, this->input_end, line);
+                if (pos >= chunk.stop) {
+                    first = chunk.steps.size();
+                    break;
+                }
+                auto synced = std::lower_bound(chunk.steps.begin(), chunk.steps.end(), pos,
+                                               [](const Compact_token &step, const char *p) {
+                                                   return step.lexeme.data() < p;
+                                               });
+                if (synced != chunk.steps.end() && synced->lexeme.data() == pos) {
+                    first = synced - chunk.steps.begin();
+                    break;
+                }
+                Munch munch;
+                continue_munch(munch, pos, this->input_end);
+                const Compact_token step = unmatched_or_token(munch, pos, this->input_end);
+                if (step.kind == DFA::NOT_ACCEPTING) {
+                    report_unmatched(line, step.lexeme);
+                    pos++;
+                } else {
+                    this->scanned.push_back(step);
+                    pos += step.lexeme.size();
+                }
+            }
+            if (first == chunk.steps.size()) {
+                // The previous chunks' tokens overran this whole chunk.
+                continue;
+            }
+        }
+        auto error = std::lower_bound(chunk.errors.begin(), chunk.errors.end(), std::make_pair(first, 0));
+        for (std::size_t k = first; k < chunk.steps.size(); k++) {
+            if (chunk.steps[k].kind == DFA::NOT_ACCEPTING) {
+                report_unmatched(chunk_line + error->second, chunk.steps[k].lexeme);
+                ++error;
+            } else {
+                this->scanned.push_back(chunk.steps[k]);
+            }
+        }
+        pos = chunk.stop;
+        line = chunk_line + chunk.newlines;
+    }
+    for (const std::vector<std::uint64_t> &starts : split_lines) {
+        this->lineStarts.insert(this->lineStarts.end(), starts.begin(), starts.end());
+    }
+}
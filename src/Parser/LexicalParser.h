@@ -5,14 +5,42 @@
 #ifndef COMPILER_LEXICALPARSER_H
 #define COMPILER_LEXICALPARSER_H
 
+#include <cstdint>
+#include <istream>
+#include <memory>
 #include <string>
-#include <fstream>
+#include <string_view>
 #include "RegularExpression.h"
+#include "Utils/MappedFile.h"
+#include "Utils/Ring_buffer.h"
+#include "Utils/SimdScan.h"
 #include "../DFA/DFA.h"
 
 struct Token {
     std::string regEXP;
     std::string match_string;
+    // Byte offset of the token in the program.
+    std::uint64_t offset{};
+};
+
+/**
+ * Token without any copies, kind is the id of its token i.e its index in get_token_names() and lexeme views
+ * the matched bytes of the input. While streaming, the input may move once more input is read, so the lexeme
+ * stays valid only until more tokens are scanned after popping the token with next_token. offset is the byte
+ * offset of the lexeme in the program, which LexicalParser::get_location turns into a line and a column.
+ */
+struct Compact_token {
+    int kind;
+    std::uint64_t offset;
+    std::string_view lexeme;
+};
+
+/**
+ * Line and column of a byte in the program, both starting from 1. Columns are counted in bytes.
+ */
+struct Source_location {
+    int line;
+    int column;
 };
 
 class LexicalParser {
@@ -20,26 +48,158 @@ public:
 
     explicit LexicalParser(const std::string &);
 
+    /**
+     * Same as above but the DFA is loaded from the DFA image at dfaImagePath when that image was built from
+     * the same rules file. Otherwise, the DFA is built from the rules and its image is written to dfaImagePath.
+     */
+    LexicalParser(const std::string &rulesFilePath, const std::string &dfaImagePath);
+
     bool get_token(Token &);
 
+    bool get_token(Compact_token &);
+
     void next_token();
 
+    /**
+     * Scans tokens until at least n of them are buffered, n being capped by TOKEN_RING_CAPACITY, or the input
+     * ends. Returns the number of buffered tokens, which may be less than n only at the end of the input.
+     */
+    std::size_t fill(std::size_t n);
+
+    /**
+     * Assigns the k-th buffered token to token, 0 being the one returned by get_token, scanning more tokens if
+     * needed. Returns false if the input ends before that token or k isn't less than TOKEN_RING_CAPACITY.
+     */
+    bool peek(std::size_t k, Compact_token &token);
+
+    static constexpr std::size_t TOKEN_RING_CAPACITY = 1024;
+
+    // Tokens scanned at once whenever get_token finds the buffer empty.
+    static constexpr std::size_t TOKEN_BATCH = 256;
+
     void set_input_stream(const std::string &);
 
+    /**
+     * Scans the given stream, which must outlive the scanning, in chunks of CHUNK_SIZE bytes. Only the bytes of
+     * the buffered tokens and of the token being matched are kept, so memory doesn't depend on the input size.
+     */
+    void set_input_stream(std::istream &);
+
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+    /**
+     * Size of the buffer the input stream is read into, which grows with the bytes of the buffered lexemes and of
+     * the token being matched but not with the whitespaces between tokens.
+     */
+    std::size_t stream_buffer_size() const;
+
+    /**
+     * Where the program is split to be scanned on several threads. LINES splits right after newlines, which end
+     * every token. SPECULATIVE splits anywhere, each chunk being scanned as if a token started there, and then
+     * rescans from where the previous chunk really stopped until agreeing with the chunk's tokens. It only saves
+     * searching for newlines, e.g in programs without any: tokens still end at whitespaces as in a single scan.
+     */
+    enum class Split {
+        LINES, SPECULATIVE
+    };
+
+    /**
+     * Maps the whole program file and scans it right away, splitting it into at most the given number of chunks
+     * of at least MIN_PARALLEL_CHUNK bytes each scanned on its own thread with the shared DFA. The tokens are then
+     * returned in order by get_token, and unmatched words are reported with their lines as if scanned in order.
+     */
+    void set_input_stream(const std::string &, unsigned threads, Split split = Split::LINES);
+
+    static constexpr std::size_t MIN_PARALLEL_CHUNK = 64 * 1024;
+
+    /**
+     * Location of the byte at the given offset, e.g a token's offset. Lines are indexed while scanning, so the
+     * offset must be before the last token scanned so far. While streaming, the lines before the last token popped
+     * by next_token are dropped, so the offset mustn't be before that token either.
+     */
+    Source_location get_location(std::uint64_t offset) const;
+
     bool has_grammar_error() const;
 
+    const DFA &get_DFA() const;
+
+    const std::vector<std::string> &get_token_names() const;
+
 private:
     bool grammar_parsing_error{};
-    std::fstream file_stream;
-    std::queue<Token> tokenBuffer;
-    int line_number{};
+    // The whole program file, which is scanned in place.
+    std::unique_ptr<MappedFile> input;
+    // Input stream which is read in chunks into window, if any.
+    std::istream *stream{};
+    std::vector<char> window;
+    // Next byte to scan and the end of the input read so far.
+    const char *cursor{};
+    const char *input_end{};
+    // Where the mapped file starts, or where the window's bytes after the buffered lexemes start, and its offset in
+    // the program.
+    const char *input_begin{};
+    std::size_t input_begin_offset{};
+    // Offset of the first byte of every line scanned so far, but the first droppedLines lines.
+    std::vector<std::uint64_t> lineStarts;
+    std::size_t droppedLines{};
+    // Offset of the last token popped by next_token.
+    std::uint64_t poppedOffset{};
+    Ring_buffer<Compact_token, TOKEN_RING_CAPACITY> tokenBuffer;
+    // Tokens of the whole program scanned on several threads, which are buffered from scannedNext on.
+    std::vector<Compact_token> scanned;
+    std::size_t scannedNext{};
     const DFA dfa;
+    // Bytes which keep each state of the DFA in the same state, empty if there are too many ranges of them.
+    const std::vector<ByteRanges> selfLoops;
+
+    std::size_t scan_tokens(std::size_t n);
+
+    bool read_chunk();
+
+    void performMaximalMunch();
+
+    // DFA walk of a single token, which may be resumed once more input is read.
+    struct Munch {
+        int state{DFA::START_STATE};
+        std::size_t length{};
+        int lastAcceptingState{-1};
+        std::size_t lastAcceptingLength{};
+        // Whether no longer token can be matched.
+        bool stopped{};
+    };
+
+    void continue_munch(Munch &, const char *begin, const char *end) const;
 
-    int get_next_line();
+    Compact_token unmatched_or_token(const Munch &, const char *begin, const char *end) const;
 
-    void performMaximalMunch(const std::string &);
+    static void report_unmatched(int line, std::string_view word);
+
+    std::uint64_t offset_of(const char *p) const;
+
+    void find_line_starts(const char *begin, const char *end, std::vector<std::uint64_t> &starts) const;
+
+    void drop_popped_lines();
+
+    // Scan of a chunk of the program on its own thread.
+    struct Chunk_scan {
+        // Tokens starting in the chunk in order, unmatched words included as tokens of kind NOT_ACCEPTING.
+        std::vector<Compact_token> steps;
+        // Index in steps of every unmatched word along with the newlines from the chunk's start to it.
+        std::vector<std::pair<std::size_t, int>> errors;
+        // Where the scan resumes after the chunk and the newlines up to there.
+        const char *stop{};
+        int newlines{};
+    };
+
+    void scan_chunk(const char *begin, const char *chunk_end, Chunk_scan &) const;
+
+    void scan_parallel(const std::vector<const char *> &splits);
 
     DFA parse(const std::string &);
+
+    static std::vector<ByteRanges> find_self_loops(const DFA &);
+
+    DFA load_or_parse(const std::string &rulesFilePath, const std::string &dfaImagePath);
 };
 
 #endif //COMPILER_LEXICALPARSER_H
@@ -0,0 +1,53 @@
+#ifndef COMPILER_BUMP_ARENA_H
+#define COMPILER_BUMP_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Allocates arrays of T by bumping a pointer through blocks of BLOCK_SIZE items, so allocating is a few adds and
+ * all arrays are freed at once with the arena. Allocated items stay at the same address until then. T is never
+ * destroyed, so it must be trivially destructible.
+ */
+template<typename T, std::size_t BLOCK_SIZE = 4096>
+class Bump_arena {
+    static_assert(std::is_trivially_destructible<T>::value, "Items of the arena are never destroyed.");
+
+public:
+    /**
+     * Returns n contiguous value-initialized items.
+     */
+    T *allocate(std::size_t n) {
+        if (n > left) {
+            // Bigger arrays get a block of their own.
+            const std::size_t size = std::max(n, BLOCK_SIZE);
+            blocks.push_back(std::make_unique<T[]>(size));
+            next = blocks.back().get();
+            left = size;
+            capacity += size;
+        }
+        T *items = next;
+        next += n;
+        left -= n;
+        return items;
+    }
+
+    /**
+     * Number of items of all blocks, allocated or not.
+     */
+    std::size_t reserved() const {
+        return capacity;
+    }
+
+private:
+    std::vector<std::unique_ptr<T[]>> blocks;
+    T *next{};
+    std::size_t left{};
+    std::size_t capacity{};
+};
+
+
+#endif //COMPILER_BUMP_ARENA_H
@@ -0,0 +1,56 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+
+#include <fstream>
+#include <iterator>
+
+MappedFile::MappedFile(const std::string &path) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return;
+    }
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    begin = content.data();
+    length = content.size();
+    opened = true;
+}
+
+MappedFile::~MappedFile() = default;
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        if (info.st_size == 0) {
+            opened = true;
+        } else {
+            void *address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                begin = static_cast<const char *>(address);
+                length = info.st_size;
+                opened = mapped = true;
+            }
+        }
+    }
+    // The mapping stays valid after closing the descriptor.
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (mapped) {
+        munmap(const_cast<char *>(begin), length);
+    }
+}
+
+#endif
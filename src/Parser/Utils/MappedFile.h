@@ -0,0 +1,46 @@
+#ifndef COMPILER_MAPPEDFILE_H
+#define COMPILER_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Read-only view of a whole file. The file is memory mapped where mmap is available so opening it
+ * doesn't read anything up front, otherwise its content is read into memory.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path);
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile();
+
+    bool is_open() const {
+        return opened;
+    }
+
+    const char *data() const {
+        return begin;
+    }
+
+    std::size_t size() const {
+        return length;
+    }
+
+private:
+    bool opened{};
+    const char *begin{""};
+    std::size_t length{};
+#ifdef _WIN32
+    std::string content;
+#else
+    // Whether begin points to a mapping that has to be unmapped, empty files are never mapped.
+    bool mapped{};
+#endif
+};
+
+
+#endif //COMPILER_MAPPEDFILE_H
@@ -0,0 +1,78 @@
+#ifndef COMPILER_RING_BUFFER_H
+#define COMPILER_RING_BUFFER_H
+
+#include <array>
+#include <cstddef>
+
+/**
+ * Fixed-capacity FIFO queue stored in a single array, so pushing and popping never allocate. Items are indexed
+ * from the front, i.e (*this)[0] is the oldest item. The capacity must be a power of two so that wrapping around
+ * is a mask instead of a division.
+ */
+template<typename T, std::size_t Capacity>
+class Ring_buffer {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+public:
+    static constexpr std::size_t capacity() {
+        return Capacity;
+    }
+
+    std::size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    bool full() const {
+        return count == Capacity;
+    }
+
+    T &operator[](std::size_t k) {
+        return items[(head + k) & MASK];
+    }
+
+    const T &operator[](std::size_t k) const {
+        return items[(head + k) & MASK];
+    }
+
+    T &front() {
+        return items[head];
+    }
+
+    const T &front() const {
+        return items[head];
+    }
+
+    /**
+     * Appends the given item, the buffer must not be full.
+     */
+    void push_back(const T &item) {
+        items[(head + count) & MASK] = item;
+        count++;
+    }
+
+    /**
+     * Removes the oldest item, the buffer must not be empty.
+     */
+    void pop_front() {
+        head = (head + 1) & MASK;
+        count--;
+    }
+
+    void clear() {
+        head = count = 0;
+    }
+
+private:
+    static constexpr std::size_t MASK = Capacity - 1;
+
+    std::array<T, Capacity> items{};
+    std::size_t head{};
+    std::size_t count{};
+};
+
+
+#endif //COMPILER_RING_BUFFER_H
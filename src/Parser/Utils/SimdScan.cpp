@@ -0,0 +1,139 @@
+#include <algorithm>
+#include "SimdScan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_SCAN_X86
+#include <immintrin.h>
+#endif
+
+const ByteRanges SimdScan::SPACES{2, {'\t', ' '}, {'\r', ' '}};
+
+namespace {
+    const char *skip_run_scalar(const char *p, const char *end, const ByteRanges &ranges) {
+        while (p != end && ranges.contains(static_cast<unsigned char>(*p))) {
+            p++;
+        }
+        return p;
+    }
+
+#ifdef SIMD_SCAN_X86
+
+    // Bytes are unsigned while SSE2 only compares signed bytes, so lo <= c is checked as max(c, lo) == c.
+    __attribute__((target("sse2")))
+    const char *skip_run_sse2(const char *p, const char *end, const ByteRanges &ranges) {
+        __m128i lo[ByteRanges::MAX_RANGES], hi[ByteRanges::MAX_RANGES];
+        for (int i = 0; i < ranges.count; i++) {
+            lo[i] = _mm_set1_epi8(static_cast<char>(ranges.lo[i]));
+            hi[i] = _mm_set1_epi8(static_cast<char>(ranges.hi[i]));
+        }
+        while (end - p >= 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            __m128i in = _mm_setzero_si128();
+            for (int i = 0; i < ranges.count; i++) {
+                in = _mm_or_si128(in, _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(bytes, lo[i]), bytes),
+                                                    _mm_cmpeq_epi8(_mm_min_epu8(bytes, hi[i]), bytes)));
+            }
+            const unsigned out = ~static_cast<unsigned>(_mm_movemask_epi8(in)) & 0xFFFFu;
+            if (out != 0) {
+                return p + __builtin_ctz(out);
+            }
+            p += 16;
+        }
+        return skip_run_scalar(p, end, ranges);
+    }
+
+    __attribute__((target("avx2")))
+    const char *skip_run_avx2(const char *p, const char *end, const ByteRanges &ranges) {
+        __m256i lo[ByteRanges::MAX_RANGES], hi[ByteRanges::MAX_RANGES];
+        for (int i = 0; i < ranges.count; i++) {
+            lo[i] = _mm256_set1_epi8(static_cast<char>(ranges.lo[i]));
+            hi[i] = _mm256_set1_epi8(static_cast<char>(ranges.hi[i]));
+        }
+        while (end - p >= 32) {
+            const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+            __m256i in = _mm256_setzero_si256();
+            for (int i = 0; i < ranges.count; i++) {
+                in = _mm256_or_si256(in, _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(bytes, lo[i]), bytes),
+                                                          _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, hi[i]), bytes)));
+            }
+            const unsigned out = ~static_cast<unsigned>(_mm256_movemask_epi8(in));
+            if (out != 0) {
+                return p + __builtin_ctz(out);
+            }
+            p += 32;
+        }
+        return skip_run_sse2(p, end, ranges);
+    }
+
+#endif
+
+    SimdScan::Isa detect() {
+#ifdef SIMD_SCAN_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdScan::Isa::AVX2;
+        }
+        if (__builtin_cpu_supports("sse2")) {
+            return SimdScan::Isa::SSE2;
+        }
+#endif
+        return SimdScan::Isa::SCALAR;
+    }
+}
+
+SimdScan::Isa SimdScan::best() {
+    static const Isa isa = detect();
+    return isa;
+}
+
+bool SimdScan::supports(Isa isa) {
+    return isa <= best();
+}
+
+const char *SimdScan::skip_run(const char *begin, const char *end, const ByteRanges &ranges) {
+    return skip_run(begin, end, ranges, best());
+}
+
+const char *SimdScan::skip_run(const char *begin, const char *end, const ByteRanges &ranges, Isa isa) {
+    // Most runs end within a few bytes, which is checked before setting up any vector.
+    if (begin == end || !ranges.contains(static_cast<unsigned char>(*begin))) {
+        return begin;
+    }
+    switch (isa) {
+#ifdef SIMD_SCAN_X86
+        case Isa::AVX2:
+            return skip_run_avx2(begin + 1, end, ranges);
+        case Isa::SSE2:
+            return skip_run_sse2(begin + 1, end, ranges);
+#endif
+        default:
+            return skip_run_scalar(begin + 1, end, ranges);
+    }
+}
+
+const char *SimdScan::skip_spaces(const char *begin, const char *end, int &newlines) {
+    const char *run_end = skip_run(begin, end, SPACES);
+    newlines += static_cast<int>(std::count(begin, run_end, '\n'));
+    return run_end;
+}
+
+bool SimdScan::to_ranges(const std::bitset<256> &bytes, ByteRanges &ranges) {
+    ranges = {};
+    for (int c = 0; c < 256; c++) {
+        if (!bytes[c] || (c > 0 && bytes[c - 1])) {
+            continue;
+        }
+        if (ranges.count == ByteRanges::MAX_RANGES) {
+            ranges = {};
+            return false;
+        }
+        int last = c;
+        while (last + 1 < 256 && bytes[last + 1]) {
+            last++;
+        }
+        ranges.lo[ranges.count] = static_cast<unsigned char>(c);
+        ranges.hi[ranges.count] = static_cast<unsigned char>(last);
+        ranges.count++;
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+#ifndef COMPILER_SIMDSCAN_H
+#define COMPILER_SIMDSCAN_H
+
+#include <array>
+#include <bitset>
+
+/**
+ * Set of bytes made of at most MAX_RANGES inclusive ranges, e.g letters and digits are [0-9], [A-Z] and [a-z].
+ * Checking whether a byte is in a range takes two compares, so a whole vector of bytes is checked at once.
+ */
+struct ByteRanges {
+    static constexpr int MAX_RANGES = 4;
+
+    int count{};
+    std::array<unsigned char, MAX_RANGES> lo{};
+    std::array<unsigned char, MAX_RANGES> hi{};
+
+    bool contains(unsigned char c) const {
+        for (int i = 0; i < count; i++) {
+            if (lo[i] <= c && c <= hi[i]) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * Finds the end of runs of bytes with SSE2 or AVX2 where the CPU supports them, otherwise one byte at a time.
+ * The instruction set is picked once at runtime so the same binary runs everywhere.
+ */
+class SimdScan {
+public:
+    enum class Isa {
+        SCALAR, SSE2, AVX2
+    };
+
+    /**
+     * Returns the first byte of [begin, end) which isn't in ranges, or end if there's no such byte.
+     */
+    static const char *skip_run(const char *begin, const char *end, const ByteRanges &ranges);
+
+    /**
+     * Same as above but using the given instruction set, which must be supported.
+     */
+    static const char *skip_run(const char *begin, const char *end, const ByteRanges &ranges, Isa isa);
+
+    /**
+     * Returns the first byte of [begin, end) which isn't a whitespace, adding the skipped '\n' to newlines.
+     */
+    static const char *skip_spaces(const char *begin, const char *end, int &newlines);
+
+    static bool supports(Isa isa);
+
+    /**
+     * The instruction set used by skip_run.
+     */
+    static Isa best();
+
+    /**
+     * Turns the given set into ranges. Returns false, leaving ranges empty, if it needs more than
+     * ByteRanges::MAX_RANGES ranges.
+     */
+    static bool to_ranges(const std::bitset<256> &bytes, ByteRanges &ranges);
+
+    // Same chars as std::isspace in the default locale, i.e '\t' to '\r' and ' '.
+    static const ByteRanges SPACES;
+};
+
+
+#endif //COMPILER_SIMDSCAN_H
@@ -0,0 +1,46 @@
+#ifndef COMPILER_DERIVATION_SINK_H
+#define COMPILER_DERIVATION_SINK_H
+
+#include <vector>
+#include "Syntax_definitions.h"
+#include "../Parser/LexicalParser.h"
+
+/**
+ * Receives the steps of the leftmost derivation while Syntax_parser parses, so the derivation is never held in
+ * memory. Symbols are given as their ids in the parsing table. Every step applies to the leftmost symbol of the
+ * current sentential form which isn't a matched terminal, starting from the start symbol alone.
+ */
+class Derivation_sink {
+public:
+    virtual ~Derivation_sink() = default;
+
+    /**
+     * Called before any other step. symbols is the Symbol of every id, which stays valid during the parse.
+     */
+    virtual void start(const std::vector<Symbol> &symbols, int start_symbol) = 0;
+
+    /**
+     * The non terminal is replaced by the symbols of the given production of the table, epsilon being left out.
+     */
+    virtual void expand(int non_terminal, int production, const int *begin, const int *end) = 0;
+
+    /**
+     * The non terminal is popped by error recovery.
+     */
+    virtual void pop(int non_terminal) = 0;
+
+    /**
+     * The terminal is matched by the given token, or inserted by error recovery if token is nullptr.
+     */
+    virtual void match(int /*terminal*/, const Compact_token * /*token*/) {
+    }
+
+    /**
+     * The token is discarded by error recovery.
+     */
+    virtual void discard(const Compact_token & /*token*/) {
+    }
+};
+
+
+#endif //COMPILER_DERIVATION_SINK_H
@@ -0,0 +1,106 @@
+#include "Derivation_writer.h"
+
+Derivation_writer::Derivation_writer(std::ostream &out, Format format) : out(out), format(format) {
+    buffer.reserve(BUFFER_SIZE);
+}
+
+Derivation_writer::~Derivation_writer() {
+    flush();
+}
+
+void Derivation_writer::flush() {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+void Derivation_writer::write(std::string_view text) {
+    if (buffer.size() + text.size() > BUFFER_SIZE) {
+        flush();
+        if (text.size() > BUFFER_SIZE) {
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+            return;
+        }
+    }
+    buffer.append(text);
+}
+
+// Writes the symbol followed by a space, terminals being quoted.
+void Derivation_writer::write_symbol(int symbol) {
+    const Symbol &written = (*symbols)[symbol];
+    if (written.type == Symbol::Type::TERMINAL) {
+        write("'");
+        write(written.name);
+        write("' ");
+    } else {
+        write(written.name);
+        write(" ");
+    }
+}
+
+void Derivation_writer::write_form() {
+    write(prefix);
+    for (std::size_t i = pending.size(); i-- > 0;) {
+        write_symbol(pending[i]);
+    }
+    write("\n");
+}
+
+void Derivation_writer::start(const std::vector<Symbol> &table_symbols, int start_symbol) {
+    symbols = &table_symbols;
+    prefix.clear();
+    pending.assign(1, start_symbol);
+    if (format == Format::FORMS) {
+        write_form();
+    } else {
+        write((*symbols)[start_symbol].name);
+        write("\n");
+    }
+}
+
+void Derivation_writer::expand(int non_terminal, int /*production*/, const int *begin, const int *end) {
+    if (format == Format::FORMS) {
+        pending.pop_back();
+        for (const int *symbol = end; symbol != begin;) {
+            pending.push_back(*--symbol);
+        }
+        write_form();
+        return;
+    }
+    write((*symbols)[non_terminal].name);
+    write(" ->");
+    if (begin == end) {
+        write(" ");
+        write(eps_symbol.name);
+    }
+    for (const int *symbol = begin; symbol != end; symbol++) {
+        write(" ");
+        const Symbol &written = (*symbols)[*symbol];
+        if (written.type == Symbol::Type::TERMINAL) {
+            write("'");
+            write(written.name);
+            write("'");
+        } else {
+            write(written.name);
+        }
+    }
+    write("\n");
+}
+
+void Derivation_writer::pop(int non_terminal) {
+    if (format == Format::FORMS) {
+        pending.pop_back();
+        write_form();
+        return;
+    }
+    write((*symbols)[non_terminal].name);
+    write(" popped\n");
+}
+
+void Derivation_writer::match(int terminal, const Compact_token * /*token*/) {
+    if (format == Format::FORMS) {
+        pending.pop_back();
+        prefix += "'";
+        prefix += (*symbols)[terminal].name;
+        prefix += "' ";
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef COMPILER_DERIVATION_WRITER_H
+#define COMPILER_DERIVATION_WRITER_H
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Derivation_sink.h"
+
+/**
+ * Writes the leftmost derivation to a stream while it's being parsed, through a buffer of BUFFER_SIZE bytes.
+ *
+ * FORMS writes every sentential form on its own line, terminals being quoted and every symbol followed by a space.
+ * Only the current form is kept, its matched terminals being kept as their written text.
+ * DELTAS writes the start symbol, then one line per step: "A -> X Y" for an expansion, "A -> #" for an
+ * expansion to epsilon and "A popped" for a non terminal popped by error recovery. Each step applies to the
+ * leftmost non terminal of the form, so the forms can be rebuilt from the steps, while nothing but the buffer is
+ * kept.
+ */
+class Derivation_writer : public Derivation_sink {
+public:
+    enum class Format {
+        FORMS, DELTAS
+    };
+
+    static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+    Derivation_writer(std::ostream &out, Format format);
+
+    ~Derivation_writer() override;
+
+    void start(const std::vector<Symbol> &symbols, int start_symbol) override;
+
+    void expand(int non_terminal, int production, const int *begin, const int *end) override;
+
+    void pop(int non_terminal) override;
+
+    void match(int terminal, const Compact_token *token) override;
+
+    /**
+     * Writes the buffered bytes to the stream.
+     */
+    void flush();
+
+private:
+    std::ostream &out;
+    const Format format;
+    std::string buffer;
+    const std::vector<Symbol> *symbols{};
+    // Text of the matched terminals of the current form, and its other symbols, the last one being the leftmost.
+    std::string prefix;
+    std::vector<int> pending;
+
+    void write(std::string_view text);
+
+    void write_symbol(int symbol);
+
+    void write_form();
+};
+
+
+#endif //COMPILER_DERIVATION_WRITER_H
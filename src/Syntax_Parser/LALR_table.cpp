@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <set>
+#include "LALR_table.h"
+
+LALR_table::LALR_table(const std::unordered_map<Symbol, Rule> &rules, const Symbol &start_symbol) {
+    Syntax_Utils utils{rules, start_symbol};
+    intern_symbols(rules, utils);
+    add_productions(rules, start_symbol);
+    add_items(utils);
+    build_states();
+    compute_lookaheads();
+    fill_tables();
+}
+
+/*
+ * Terminals take the ids of their indices in utils, $ included, then the non terminals are sorted and followed by
+ * the added start symbol S', which is named after S with as many dashes as needed to be a new symbol.
+ */
+void LALR_table::intern_symbols(const std::unordered_map<Symbol, Rule> &rules, const Syntax_Utils &utils) {
+    for (int terminal = 0; terminal < utils.terminal_count(); terminal++) {
+        symbols.push_back(utils.get_terminal(terminal));
+    }
+    terminal_count = (int) symbols.size();
+    std::set<Symbol> nonTerminals;
+    for (const auto &[nonTerminal, productions] : rules) {
+        nonTerminals.insert(nonTerminal);
+    }
+    symbols.insert(symbols.end(), nonTerminals.begin(), nonTerminals.end());
+    for (int id = 0; id < (int) symbols.size(); id++) {
+        symbol_ids[symbols[id]] = id;
+    }
+}
+
+int LALR_table::get_id(const Symbol &symbol) const {
+    auto it = symbol_ids.find(symbol);
+    return it == symbol_ids.end() ? -1 : it->second;
+}
+
+void LALR_table::add_productions(const std::unordered_map<Symbol, Rule> &rules, const Symbol &start_symbol) {
+    std::string name{start_symbol.name};
+    do {
+        name += "'";
+    } while (rules.count({name, Symbol::Type::NON_TERMINAL}));
+    const int augmented = (int) symbols.size();
+    symbols.emplace_back(name, Symbol::Type::NON_TERMINAL);
+    symbol_ids[symbols.back()] = augmented;
+
+    non_terminal_productions.resize(symbols.size() - terminal_count);
+    auto add = [&](int lhs, const Production &production) {
+        non_terminal_productions[lhs - terminal_count].push_back((int) production_lhs.size());
+        production_lhs.push_back(lhs);
+        for (const Symbol &symbol : production) {
+            if (symbol.type != Symbol::Type::EPSILON) {
+                production_symbols.push_back(symbol_ids.at(symbol));
+            }
+        }
+        production_begins.push_back(production_symbols.size());
+    };
+    add(augmented, {start_symbol});
+    for (int lhs = terminal_count; lhs < augmented; lhs++) {
+        for (const Production &production : rules.at(symbols[lhs])) {
+            add(lhs, production);
+        }
+    }
+}
+
+/*
+ * The lookahead bitsets have a bit after the terminals' ones, which stands for an unknown lookahead while
+ * finding how lookaheads propagate.
+ */
+void LALR_table::add_items(const Syntax_Utils &utils) {
+    const std::size_t bits = terminal_count + 1;
+    for (int nonTerminal = terminal_count; nonTerminal < (int) symbols.size(); nonTerminal++) {
+        Syntax_Utils::Terminal_bitset first(bits);
+        utils.first_bits(symbols[nonTerminal]).for_each([&](int terminal) {
+            first.set(terminal);
+        });
+        non_terminal_first.push_back(first);
+        non_terminal_nullable.push_back(utils.is_nullable(symbols[nonTerminal]));
+    }
+
+    const int productionCount = (int) production_lhs.size();
+    item_production.reserve(production_symbols.size() + productionCount);
+    item_first.reserve(production_symbols.size() + productionCount);
+    item_nullable.reserve(production_symbols.size() + productionCount);
+    Syntax_Utils::Terminal_bitset first(bits);
+    for (int production = 0; production < productionCount; production++) {
+        const int length = get_production_length(production);
+        const int *symbol = get_production_begin(production);
+        item_production.insert(item_production.end(), length + 1, production);
+        item_first.resize(item_first.size() + length + 1);
+        item_nullable.resize(item_nullable.size() + length + 1);
+
+        // Goes backward, the item at dot being FIRST of the symbols after symbol[dot].
+        first.clear();
+        bool nullable = true;
+        for (int dot = length; dot >= 0; dot--) {
+            item_first[item_of(production) + dot] = first;
+            item_nullable[item_of(production) + dot] = nullable;
+            if (dot == length) {
+                continue;
+            }
+            if (is_terminal(symbol[dot])) {
+                first.clear();
+                first.set(symbol[dot]);
+                nullable = false;
+            } else if (non_terminal_nullable[symbol[dot] - terminal_count]) {
+                first.merge(non_terminal_first[symbol[dot] - terminal_count]);
+            } else {
+                first = non_terminal_first[symbol[dot] - terminal_count];
+                nullable = false;
+            }
+        }
+    }
+}
+
+int LALR_table::next_symbol(int item) const {
+    const int production = item_production[item];
+    const int dot = item - item_of(production);
+    return dot < get_production_length(production) ? get_production_begin(production)[dot] : -1;
+}
+
+std::vector<int> LALR_table::closure(const std::vector<int> &kernel) const {
+    std::vector<int> items = kernel;
+    std::vector<char> added(non_terminal_productions.size(), false);
+    for (std::size_t i = 0; i < items.size(); i++) {
+        const int symbol = next_symbol(items[i]);
+        if (symbol < 0 || is_terminal(symbol) || added[symbol - terminal_count]) {
+            continue;
+        }
+        added[symbol - terminal_count] = true;
+        for (int production : non_terminal_productions[symbol - terminal_count]) {
+            items.push_back(item_of(production));
+        }
+    }
+    return items;
+}
+
+/*
+ * Builds the LR(0) states, each state being identified by its sorted kernel items.
+ */
+void LALR_table::build_states() {
+    std::map<std::vector<int>, int> states;
+    kernels.push_back({item_of(ACCEPT_PRODUCTION)});
+    states[kernels[0]] = 0;
+    for (int state = 0; state < (int) kernels.size(); state++) {
+        std::map<int, std::vector<int>> targets;
+        for (int item : closure(kernels[state])) {
+            const int symbol = next_symbol(item);
+            if (symbol >= 0) {
+                targets[symbol].push_back(item + 1);
+            }
+        }
+        transitions.emplace_back();
+        for (auto &[symbol, kernel] : targets) {
+            std::sort(kernel.begin(), kernel.end());
+            auto [it, inserted] = states.try_emplace(kernel, (int) kernels.size());
+            if (inserted) {
+                kernels.push_back(kernel);
+            }
+            transitions[state].emplace_back(symbol, it->second);
+        }
+    }
+
+    kernel_offsets.push_back(0);
+    for (const std::vector<int> &kernel : kernels) {
+        kernel_offsets.push_back(kernel_offsets.back() + kernel.size());
+    }
+}
+
+int LALR_table::find_target(int state, int symbol) const {
+    const auto &stateTransitions = transitions[state];
+    return std::lower_bound(stateTransitions.begin(), stateTransitions.end(), std::make_pair(symbol, -1))->second;
+}
+
+int LALR_table::kernel_index(int state, int item) const {
+    return (int) (std::lower_bound(kernels[state].begin(), kernels[state].end(), item) - kernels[state].begin());
+}
+
+/*
+ * A non terminal B in the closure has the lookaheads FIRST(β), along with the lookaheads of A -> α.Bβ if β
+ * derives Є, for every item A -> α.Bβ in the closure, which is found with a worklist of the non terminals whose
+ * lookaheads changed.
+ */
+void LALR_table::closure_lookaheads(int state, const Syntax_Utils::Terminal_bitset *kernel_lookaheads,
+                                    Closure &closure) const {
+    if (closure.lookaheads.empty()) {
+        closure.lookaheads.assign(non_terminal_productions.size(), Syntax_Utils::Terminal_bitset(terminal_count + 1));
+        closure.in_closure.assign(non_terminal_productions.size(), false);
+        closure.queued.assign(non_terminal_productions.size(), false);
+    }
+    for (int nonTerminal : closure.non_terminals) {
+        closure.lookaheads[nonTerminal].clear();
+        closure.in_closure[nonTerminal] = false;
+    }
+    closure.non_terminals.clear();
+
+    auto add = [&](int item, const Syntax_Utils::Terminal_bitset &itemLookaheads) {
+        const int symbol = next_symbol(item);
+        if (symbol < 0 || is_terminal(symbol)) {
+            return;
+        }
+        const int nonTerminal = symbol - terminal_count;
+        bool changed = closure.lookaheads[nonTerminal].merge(item_first[item]);
+        if (item_nullable[item]) {
+            changed |= closure.lookaheads[nonTerminal].merge(itemLookaheads);
+        }
+        if (!closure.in_closure[nonTerminal]) {
+            closure.in_closure[nonTerminal] = true;
+            closure.non_terminals.push_back(nonTerminal);
+            changed = true;
+        }
+        if (changed && !closure.queued[nonTerminal]) {
+            closure.queued[nonTerminal] = true;
+            closure.worklist.push_back(nonTerminal);
+        }
+    };
+
+    for (std::size_t k = 0; k < kernels[state].size(); k++) {
+        add(kernels[state][k], kernel_lookaheads[k]);
+    }
+    while (!closure.worklist.empty()) {
+        const int nonTerminal = closure.worklist.back();
+        closure.worklist.pop_back();
+        closure.queued[nonTerminal] = false;
+        for (int production : non_terminal_productions[nonTerminal]) {
+            add(item_of(production), closure.lookaheads[nonTerminal]);
+        }
+    }
+}
+
+/*
+ * Finds the lookaheads of the kernel items by propagation: the closure of every kernel item alone, with the
+ * unknown lookahead, gives the lookaheads which the items it moves to get spontaneously, and the items which get
+ * the unknown lookahead get all the lookaheads of that kernel item. The lookaheads are then propagated until no
+ * more lookaheads are added.
+ */
+void LALR_table::compute_lookaheads() {
+    const int unknown = terminal_count;
+    lookaheads.assign(kernel_offsets.back(), Syntax_Utils::Terminal_bitset(terminal_count + 1));
+    std::vector<std::vector<std::size_t>> propagate(kernel_offsets.back());
+    std::vector<Syntax_Utils::Terminal_bitset> kernelLookaheads;
+    Closure closure;
+
+    for (int state = 0; state < (int) kernels.size(); state++) {
+        kernelLookaheads.assign(kernels[state].size(), Syntax_Utils::Terminal_bitset(terminal_count + 1));
+        for (std::size_t k = 0; k < kernels[state].size(); k++) {
+            const std::size_t from = kernel_offsets[state] + k;
+            auto moveTo = [&](int item) {
+                const int target = find_target(state, next_symbol(item));
+                return kernel_offsets[target] + kernel_index(target, item + 1);
+            };
+
+            if (next_symbol(kernels[state][k]) >= 0) {
+                propagate[from].push_back(moveTo(kernels[state][k]));
+            }
+            kernelLookaheads[k].set(unknown);
+            closure_lookaheads(state, kernelLookaheads.data(), closure);
+            kernelLookaheads[k].reset(unknown);
+
+            for (int nonTerminal : closure.non_terminals) {
+                Syntax_Utils::Terminal_bitset &nonTerminalLookaheads = closure.lookaheads[nonTerminal];
+                const bool propagated = nonTerminalLookaheads.test(unknown);
+                nonTerminalLookaheads.reset(unknown);
+                for (int production : non_terminal_productions[nonTerminal]) {
+                    if (next_symbol(item_of(production)) < 0) {
+                        continue;
+                    }
+                    const std::size_t to = moveTo(item_of(production));
+                    lookaheads[to].merge(nonTerminalLookaheads);
+                    if (propagated) {
+                        propagate[from].push_back(to);
+                    }
+                }
+            }
+        }
+    }
+
+    lookaheads[0].set(get_id({"$", Symbol::Type::TERMINAL}));
+    std::vector<std::size_t> worklist(lookaheads.size());
+    std::vector<char> queued(lookaheads.size(), true);
+    for (std::size_t i = 0; i < worklist.size(); i++) {
+        worklist[i] = i;
+    }
+    while (!worklist.empty()) {
+        const std::size_t from = worklist.back();
+        worklist.pop_back();
+        queued[from] = false;
+        for (std::size_t to : propagate[from]) {
+            if (lookaheads[to].merge(lookaheads[from]) && !queued[to]) {
+                queued[to] = true;
+                worklist.push_back(to);
+            }
+        }
+    }
+}
+
+void LALR_table::set_action(int state, int terminal, Action action, std::vector<Action> &row) {
+    Action &entry = row[terminal];
+    if (entry == ERROR || entry == action) {
+        entry = action;
+        return;
+    }
+    has_error = true;
+    if (is_shift(entry) || is_shift(action)) {
+        std::cerr << "Shift/reduce conflict in state " << state << " on terminal = " << symbols[terminal].name
+                  << ", shifting.\n";
+        entry = std::max(entry, action);
+    } else {
+        // The production numbered first wins. Productions are numbered by their non terminals sorted by name, not
+        // by where the rules are in the CFG file, then in the order of their rule's alternatives.
+        entry = std::max(entry, action);
+        std::cerr << "Reduce/reduce conflict in state " << state << " on terminal = " << symbols[terminal].name
+                  << ", reducing by production " << reduce_production(entry) << ".\n";
+    }
+}
+
+void LALR_table::fill_tables() {
+    const std::size_t stateCount = kernels.size();
+    std::vector<std::vector<std::pair<int, Action>>> rows(stateCount);
+    default_actions.assign(stateCount, ERROR);
+    std::vector<Action> row(terminal_count);
+    Closure closure;
+    auto reduce = [](int production) {
+        return -(production + 1);
+    };
+
+    for (int state = 0; state < (int) stateCount; state++) {
+        std::fill(row.begin(), row.end(), ERROR);
+        for (auto [symbol, target] : transitions[state]) {
+            if (is_terminal(symbol)) {
+                set_action(state, symbol, target + 1, row);
+            } else {
+                rows[state].emplace_back(symbol, target + 1);
+            }
+        }
+        for (std::size_t k = 0; k < kernels[state].size(); k++) {
+            if (next_symbol(kernels[state][k]) < 0) {
+                const int production = item_production[kernels[state][k]];
+                lookaheads[kernel_offsets[state] + k].for_each([&](int terminal) {
+                    set_action(state, terminal, reduce(production), row);
+                });
+            }
+        }
+        // Productions deriving Є are reduced from the closure.
+        closure_lookaheads(state, lookaheads.data() + kernel_offsets[state], closure);
+        for (int nonTerminal : closure.non_terminals) {
+            for (int production : non_terminal_productions[nonTerminal]) {
+                if (get_production_length(production) == 0) {
+                    closure.lookaheads[nonTerminal].for_each([&](int terminal) {
+                        set_action(state, terminal, reduce(production), row);
+                    });
+                }
+            }
+        }
+
+        // The most frequent reduction, accepting aside, becomes the default action.
+        std::unordered_map<Action, int> reductions;
+        for (Action action : row) {
+            if (is_reduce(action) && reduce_production(action) != ACCEPT_PRODUCTION) {
+                const int count = ++reductions[action];
+                Action &best = default_actions[state];
+                if (best == ERROR || count > reductions[best] || (count == reductions[best] && action > best)) {
+                    best = action;
+                }
+            }
+        }
+        for (int terminal = 0; terminal < terminal_count; terminal++) {
+            if (row[terminal] != ERROR && row[terminal] != default_actions[state]) {
+                rows[state].emplace_back(terminal, row[terminal]);
+            }
+        }
+    }
+    pack(rows);
+}
+
+/*
+ * Packs the rows by first fit, the rows with the most entries first as they are the hardest to fit.
+ */
+void LALR_table::pack(const std::vector<std::vector<std::pair<int, Action>>> &rows) {
+    std::vector<int> order(rows.size());
+    for (int state = 0; state < (int) rows.size(); state++) {
+        order[state] = state;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return rows[a].size() > rows[b].size();
+    });
+
+    base.assign(rows.size(), 0);
+    for (int state : order) {
+        if (rows[state].empty()) {
+            continue;
+        }
+        auto fits = [&](std::size_t offset) {
+            for (auto [symbol, _] : rows[state]) {
+                if (offset + symbol < check.size() && check[offset + symbol] >= 0) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        std::size_t offset = 0;
+        while (!fits(offset)) {
+            offset++;
+        }
+        base[state] = offset;
+        for (auto [symbol, action] : rows[state]) {
+            if (offset + symbol >= check.size()) {
+                check.resize(offset + symbol + 1, -1);
+                packed.resize(offset + symbol + 1, ERROR);
+            }
+            check[offset + symbol] = state;
+            packed[offset + symbol] = action;
+        }
+    }
+}
+
+bool LALR_table::fail() const {
+    return has_error;
+}
@@ -0,0 +1,189 @@
+#ifndef COMPILER_LALR_TABLE_H
+#define COMPILER_LALR_TABLE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Syntax_Utils.h"
+
+/**
+ * LALR(1) action and goto tables of the grammar as it's written, left recursion included. Terminals and non
+ * terminals are interned to dense ids, terminals taking the ids before non terminals, and production 0 is the
+ * added production S' -> S of the start symbol S, reducing it meaning the input is accepted.
+ *
+ * Both tables are packed into a single comb vector: the entries of state s are at base[s] + symbol wherever the
+ * check vector holds s. The reduction occurring the most in a state's row is left out as the state's default
+ * action, so most states only keep their shifts and gotos.
+ */
+class LALR_table {
+public:
+    LALR_table(const std::unordered_map<Symbol, Rule> &rules, const Symbol &start_symbol);
+
+    /**
+     * Actions are ERROR, shift(state) which is positive and reduce(production) which is negative.
+     */
+    using Action = std::int32_t;
+    static constexpr Action ERROR = 0;
+    static constexpr int ACCEPT_PRODUCTION = 0;
+
+    static bool is_shift(Action action) {
+        return action > 0;
+    }
+
+    static bool is_reduce(Action action) {
+        return action < 0;
+    }
+
+    static int shift_state(Action action) {
+        return action - 1;
+    }
+
+    static int reduce_production(Action action) {
+        return -action - 1;
+    }
+
+    /**
+     * Action of the given state on the given terminal's id.
+     */
+    Action get_action(int state, int terminal) const {
+        const std::size_t index = base[state] + terminal;
+        return index < check.size() && check[index] == state ? packed[index] : default_actions[state];
+    }
+
+    /**
+     * State to go to from the given state after reducing to the given non terminal's id, -1 if there's none.
+     */
+    int get_goto(int state, int non_terminal) const {
+        const std::size_t index = base[state] + non_terminal;
+        return index < check.size() && check[index] == state ? packed[index] - 1 : -1;
+    }
+
+    /**
+     * Id of the given terminal or non terminal, or -1 if it's not in the grammar.
+     */
+    int get_id(const Symbol &symbol) const;
+
+    const Symbol &get_symbol(int id) const {
+        return symbols[id];
+    }
+
+    bool is_terminal(int id) const {
+        return id < terminal_count;
+    }
+
+    int get_lhs(int production) const {
+        return production_lhs[production];
+    }
+
+    /**
+     * Ids of the symbols of the given production, epsilon being left out.
+     */
+    const int *get_production_begin(int production) const {
+        return production_symbols.data() + production_begins[production];
+    }
+
+    const int *get_production_end(int production) const {
+        return production_symbols.data() + production_begins[production + 1];
+    }
+
+    int get_production_length(int production) const {
+        return (int) (production_begins[production + 1] - production_begins[production]);
+    }
+
+    int state_count() const {
+        return (int) base.size();
+    }
+
+    /**
+     * Number of entries of the packed tables, which would be state_count() times the number of symbols unpacked.
+     */
+    std::size_t packed_size() const {
+        return packed.size();
+    }
+
+    bool fail() const;
+
+private:
+    std::unordered_map<Symbol, int> symbol_ids;
+    std::vector<Symbol> symbols;
+    int terminal_count{};
+    bool has_error{};
+
+    std::vector<int> production_lhs;
+    // Symbols of all productions one after the other, production i starting at production_begins[i].
+    std::vector<int> production_symbols;
+    std::vector<std::size_t> production_begins{0};
+
+    // Item i is the dot before the i - production_begins[p] th symbol of production p = item_production[i], so the
+    // items of production p are production_begins[p] + p to production_begins[p + 1] + p.
+    std::vector<int> item_production;
+    // FIRST of the symbols after the one following the dot of every item, and whether they derive Є.
+    std::vector<Syntax_Utils::Terminal_bitset> item_first;
+    std::vector<char> item_nullable;
+    // FIRST of every non terminal, indexed by its id - terminal_count.
+    std::vector<Syntax_Utils::Terminal_bitset> non_terminal_first;
+    std::vector<char> non_terminal_nullable;
+    // Productions of every non terminal.
+    std::vector<std::vector<int>> non_terminal_productions;
+
+    // Sorted kernel items of every LR(0) state, kernel_offsets[s] being the index of state s's first kernel item
+    // among the kernel items of all states.
+    std::vector<std::vector<int>> kernels;
+    std::vector<std::size_t> kernel_offsets;
+    // Transitions of every state, sorted by symbol.
+    std::vector<std::vector<std::pair<int, int>>> transitions;
+    // Lookaheads of every kernel item of every state.
+    std::vector<Syntax_Utils::Terminal_bitset> lookaheads;
+
+    std::vector<Action> default_actions;
+    std::vector<std::size_t> base;
+    std::vector<int> check;
+    std::vector<Action> packed;
+
+    void intern_symbols(const std::unordered_map<Symbol, Rule> &rules, const Syntax_Utils &utils);
+
+    void add_productions(const std::unordered_map<Symbol, Rule> &rules, const Symbol &start_symbol);
+
+    void add_items(const Syntax_Utils &utils);
+
+    int item_of(int production) const {
+        return (int) production_begins[production] + production;
+    }
+
+    // Symbol after the dot of the given item, or -1 if the dot is at the end.
+    int next_symbol(int item) const;
+
+    std::vector<int> closure(const std::vector<int> &kernel) const;
+
+    void build_states();
+
+    int find_target(int state, int symbol) const;
+
+    int kernel_index(int state, int item) const;
+
+    // Lookaheads of the non terminals of a state's closure, which are reused from one state to the next.
+    struct Closure {
+        std::vector<Syntax_Utils::Terminal_bitset> lookaheads;
+        std::vector<char> in_closure;
+        std::vector<char> queued;
+        std::vector<int> non_terminals;
+        std::vector<int> worklist;
+    };
+
+    /**
+     * Finds the non terminals of state's closure along with their lookaheads, given the lookaheads of its kernel
+     * items one after the other.
+     */
+    void closure_lookaheads(int state, const Syntax_Utils::Terminal_bitset *kernel_lookaheads, Closure &) const;
+
+    void compute_lookaheads();
+
+    void fill_tables();
+
+    void set_action(int state, int terminal, Action action, std::vector<Action> &row);
+
+    void pack(const std::vector<std::vector<std::pair<int, Action>>> &rows);
+};
+
+
+#endif //COMPILER_LALR_TABLE_H
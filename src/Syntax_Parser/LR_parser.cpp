@@ -0,0 +1,76 @@
+#include <iostream>
+#include "LR_parser.h"
+#include "Lexical_parser_wrapper.h"
+
+LR_parser::LR_parser(const std::unordered_map<Symbol, Rule> &rules, const Symbol &starting_symbol)
+        : table(std::make_unique<LALR_table>(rules, starting_symbol)) {
+}
+
+std::pair<std::vector<int>, LR_parser::Status> LR_parser::parse(LexicalParser &parser) const {
+    Lexical_parser_wrapper tokenizer(parser);
+    std::vector<int> reductions;
+    std::vector<int> states{0};
+    Status status = Status::ACCEPTED;
+
+    // Terminal id and name of every token kind, found once so that tokens are never turned into strings.
+    std::vector<int> kind_ids;
+    std::vector<std::string> kind_names = parser.get_token_names();
+    kind_names.emplace_back("$");
+    for (const std::string &name : kind_names) {
+        kind_ids.push_back(table->get_id({name, Symbol::Type::TERMINAL}));
+    }
+
+    Compact_token curToken{};
+    while (tokenizer.get_token(curToken)) {
+        const int terminal = kind_ids[curToken.kind];
+        const LALR_table::Action action = terminal < 0 ? LALR_table::ERROR : table->get_action(states.back(), terminal);
+
+        if (LALR_table::is_shift(action)) {
+            states.push_back(LALR_table::shift_state(action));
+            tokenizer.next_token();
+            continue;
+        }
+        if (LALR_table::is_reduce(action)) {
+            const int production = LALR_table::reduce_production(action);
+            if (production == LALR_table::ACCEPT_PRODUCTION) {
+                return {reductions, status};
+            }
+            states.resize(states.size() - table->get_production_length(production));
+            states.push_back(table->get_goto(states.back(), table->get_lhs(production)));
+            reductions.push_back(production);
+            continue;
+        }
+
+        // Error recovery: The states are popped down to one which shifts the token. If there's none, or the token
+        // isn't a terminal of the grammar, the token is discarded, so every error moves past a token. The input
+        // can't be recovered once it ended.
+        status = Status::ACCEPTED_WITH_ERRORS;
+        if (curToken.kind == tokenizer.ending_kind()) {
+            std::cerr << tokenizer.error_at(curToken) << ": unexpected end of input.\n";
+            break;
+        }
+        std::size_t depth = terminal < 0 ? 0 : states.size();
+        while (depth > 0 && !LALR_table::is_shift(table->get_action(states[depth - 1], terminal))) {
+            depth--;
+        }
+        if (depth > 0) {
+            std::cerr << tokenizer.error_at(curToken) << ": (unexpected " << kind_names[curToken.kind] << ") - "
+                      << states.size() - depth << " states popped.\n";
+            states.resize(depth);
+        } else {
+            // The lexeme is printed first as it may no longer be valid after moving to the next token.
+            std::cerr << tokenizer.error_at(curToken) << ": (unexpected " << kind_names[curToken.kind]
+                      << ") - discard \"" << curToken.lexeme << "\".\n";
+            tokenizer.next_token();
+        }
+    }
+    return {reductions, Status::NOT_MATCHED};
+}
+
+const LALR_table &LR_parser::get_table() const {
+    return *table;
+}
+
+bool LR_parser::fail() const {
+    return table->fail();
+}
@@ -0,0 +1,36 @@
+#ifndef COMPILER_LR_PARSER_H
+#define COMPILER_LR_PARSER_H
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include "LALR_table.h"
+#include "Syntax_parser.h"
+#include "../Parser/LexicalParser.h"
+
+/**
+ * Shift-reduce parser driven by the LALR(1) tables of the rules, so the rules don't need to be turned into an LL(1)
+ * grammar first. Only the states are kept on the stack, and every reduction pops the production's length at once.
+ */
+class LR_parser {
+public:
+    LR_parser(const std::unordered_map<Symbol, Rule> &rules, const Symbol &starting_symbol);
+
+    using Status = Syntax_parser::Status;
+
+    /**
+     * Parses the tokens of the given lexical parser.
+     * @return the productions reduced in order, which is the rightmost derivation in reverse, along with the status.
+     */
+    std::pair<std::vector<int>, Status> parse(LexicalParser &tokenizer) const;
+
+    const LALR_table &get_table() const;
+
+    bool fail() const;
+
+private:
+    std::unique_ptr<LALR_table> table;
+};
+
+
+#endif //COMPILER_LR_PARSER_H
@@ -0,0 +1,65 @@
+#ifndef COMPILER_LEXICAL_PARSER_WRAPPER_H
+#define COMPILER_LEXICAL_PARSER_WRAPPER_H
+
+#include <cstdint>
+#include <string>
+#include "../Parser/LexicalParser.h"
+
+/**
+ * Tokens of the lexical parser followed by the $ token, which syntax parsers read until the end of the input.
+ */
+class Lexical_parser_wrapper {
+public:
+    explicit Lexical_parser_wrapper(LexicalParser &parser) : parser(parser) {
+    }
+
+    // Kind of the $ token, which comes right after the kinds of the lexical parser's tokens.
+    int ending_kind() const {
+        return (int) parser.get_token_names().size();
+    }
+
+    bool get_token(Compact_token &token) {
+        if (parser.get_token(token)) {
+            end_offset = token.offset + token.lexeme.size();
+            return true;
+        }
+        if (state == State::RET_ENDING_SYMBOL) {
+            // $ is located right after the last token.
+            token = {ending_kind(), end_offset, "$"};
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Prefix of error messages pointing at the given token.
+     */
+    std::string error_at(const Compact_token &token) const {
+        const Source_location location = parser.get_location(token.offset);
+        return "Error in line " + std::to_string(location.line) + ", column " + std::to_string(location.column);
+    }
+
+    void next_token() {
+        parser.next_token();
+        // Add $ at the end for syntax parser if buffer is empty
+        if (Compact_token temp{}; !get_token(temp) && state == State::RET_FROM_PARSER) {
+            state = State::RET_ENDING_SYMBOL;
+            return;
+        }
+        // Calling next_token after ending symbol.
+        if (state == State::RET_ENDING_SYMBOL) {
+            state = State::EMPTY_BUFFER;
+        }
+    }
+
+private:
+    LexicalParser &parser;
+    enum class State {
+        RET_FROM_PARSER, RET_ENDING_SYMBOL, EMPTY_BUFFER
+    };
+    State state = State::RET_FROM_PARSER;
+    std::uint64_t end_offset{};
+};
+
+
+#endif //COMPILER_LEXICAL_PARSER_WRAPPER_H
@@ -0,0 +1,123 @@
+#include <utility>
+#include "Parse_tree.h"
+
+Parse_tree::Parse_tree(std::vector<Symbol> symbols, int start_symbol) : symbols(std::move(symbols)) {
+    root = nodes.allocate(1);
+    *root = {start_symbol, NO_TOKEN, UNEXPANDED, 0, nullptr};
+}
+
+void Parse_tree::expand(Node &node, std::int16_t production, const int *begin, const int *end) {
+    node.production = production;
+    node.child_count = static_cast<std::uint32_t>(end - begin);
+    node.children = nodes.allocate(node.child_count);
+    for (std::uint32_t i = 0; i < node.child_count; i++) {
+        node.children[i] = {begin[i], NO_TOKEN, UNEXPANDED, 0, nullptr};
+    }
+}
+
+void Parse_tree::write(std::ostream &out) const {
+    if (root == nullptr) {
+        return;
+    }
+    // Nodes along with their depth, the last one being written first.
+    std::vector<std::pair<const Node *, int>> stack{{root, 0}};
+    while (!stack.empty()) {
+        auto [node, depth] = stack.back();
+        stack.pop_back();
+        out << std::string(2 * depth, ' ');
+        const Symbol &symbol = get_symbol(*node);
+        if (symbol.type == Symbol::Type::TERMINAL) {
+            out << "'" << symbol.name << "'";
+            if (node->token == NO_TOKEN) {
+                out << " (missing)";
+            } else {
+                const Source_location location = get_token_location(node->token);
+                out << " line " << location.line << ", column " << location.column;
+            }
+        } else {
+            out << symbol.name;
+            if (node->production == POPPED) {
+                out << " (popped)";
+            }
+        }
+        out << "\n";
+        for (std::uint32_t i = node->child_count; i-- > 0;) {
+            stack.emplace_back(node->children + i, depth + 1);
+        }
+    }
+}
+
+Parse_tree::Leftmost_derivation::Leftmost_derivation(const Parse_tree &tree) : tree(tree) {
+}
+
+/*
+ * Walks the tree the same way the parser built it: terminals are moved to the prefix, and the next non terminal
+ * is replaced by its children, each of these giving a form.
+ */
+bool Parse_tree::Leftmost_derivation::next(std::vector<Symbol> &form) {
+    if (!started) {
+        started = true;
+        if (tree.root == nullptr) {
+            return false;
+        }
+        pending.push_back(tree.root);
+        form.assign(1, tree.get_symbol(*tree.root));
+        return true;
+    }
+    while (!pending.empty()) {
+        const Node *node = pending.back();
+        if (tree.get_symbol(*node).type == Symbol::Type::TERMINAL) {
+            prefix.push_back(tree.get_symbol(*node));
+            pending.pop_back();
+            continue;
+        }
+        if (node->production == UNEXPANDED) {
+            // The parser stopped here.
+            return false;
+        }
+        pending.pop_back();
+        for (std::uint32_t i = node->child_count; i-- > 0;) {
+            pending.push_back(node->children + i);
+        }
+        form = prefix;
+        for (std::size_t i = pending.size(); i-- > 0;) {
+            form.push_back(tree.get_symbol(*pending[i]));
+        }
+        return true;
+    }
+    return false;
+}
+
+Parse_tree::Builder::Builder(Parse_tree &tree, const LexicalParser &parser) : tree(tree), parser(parser) {
+}
+
+void Parse_tree::Builder::start(const std::vector<Symbol> &symbols, int start_symbol) {
+    tree = Parse_tree(symbols, start_symbol);
+    pending.assign(1, tree.root);
+}
+
+void Parse_tree::Builder::expand(int /*non_terminal*/, int production, const int *begin, const int *end) {
+    Node &node = *pending.back();
+    pending.pop_back();
+    tree.expand(node, static_cast<std::int16_t>(production), begin, end);
+    for (std::uint32_t i = node.child_count; i-- > 0;) {
+        pending.push_back(node.children + i);
+    }
+}
+
+void Parse_tree::Builder::pop(int /*non_terminal*/) {
+    pending.back()->production = POPPED;
+    pending.pop_back();
+}
+
+void Parse_tree::Builder::match(int /*terminal*/, const Compact_token *token) {
+    if (token != nullptr) {
+        pending.back()->token = static_cast<std::uint32_t>(tree.token_count());
+        tree.token_locations.push_back(parser.get_location(token->offset));
+    }
+    pending.pop_back();
+}
+
+void Parse_tree::Builder::discard(const Compact_token &token) {
+    tree.token_locations.push_back(parser.get_location(token.offset));
+}
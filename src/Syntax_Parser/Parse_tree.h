@@ -0,0 +1,124 @@
+#ifndef COMPILER_PARSE_TREE_H
+#define COMPILER_PARSE_TREE_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "Derivation_sink.h"
+#include "Syntax_definitions.h"
+#include "../Parser/LexicalParser.h"
+#include "../Parser/Utils/Bump_arena.h"
+
+/**
+ * Parse tree built by Syntax_parser, whose nodes are allocated in a bump arena with the children of every node
+ * next to each other. Symbols are kept as their ids in the parsing table, and matched terminals as the index of
+ * their token in the program, so the tree doesn't hold any strings.
+ */
+class Parse_tree {
+public:
+    static constexpr std::uint32_t NO_TOKEN = UINT32_MAX;
+
+    // Productions of non terminals which aren't expansions.
+    static constexpr std::int16_t UNEXPANDED = -1;
+    static constexpr std::int16_t POPPED = -2;
+
+    struct Node {
+        int symbol;
+        // Index of the token matched by a terminal, NO_TOKEN if the terminal was missing and inserted.
+        std::uint32_t token;
+        // Production expanding a non terminal, UNEXPANDED if the input ended first or POPPED by error recovery.
+        std::int16_t production;
+        std::uint32_t child_count;
+        Node *children;
+    };
+
+    Parse_tree() = default;
+
+    Parse_tree(std::vector<Symbol> symbols, int start_symbol);
+
+    const Node *get_root() const {
+        return root;
+    }
+
+    const Symbol &get_symbol(const Node &node) const {
+        return symbols[node.symbol];
+    }
+
+    /**
+     * Location in the program of the token at the given index, tokens discarded by error recovery included.
+     */
+    Source_location get_token_location(std::uint32_t token) const {
+        return token_locations[token];
+    }
+
+    std::size_t token_count() const {
+        return token_locations.size();
+    }
+
+    /**
+     * Writes the tree one node per line indented by its depth, matched terminals being followed by the location
+     * of their token.
+     */
+    void write(std::ostream &) const;
+
+    /**
+     * Leftmost derivation of the tree, whose sentential forms are made one at a time on demand, so only the
+     * current form is held in memory. Every form follows the expansion of a non terminal, or its popping by
+     * error recovery, in the order the parser did them, the first form being the start symbol alone.
+     */
+    class Leftmost_derivation {
+    public:
+        explicit Leftmost_derivation(const Parse_tree &);
+
+        /**
+         * Assigns the next sentential form to form. Returns false if there's none.
+         */
+        bool next(std::vector<Symbol> &form);
+
+    private:
+        const Parse_tree &tree;
+        // Terminals before the next non terminal to expand and the nodes after them, the last one being first.
+        std::vector<Symbol> prefix;
+        std::vector<const Node *> pending;
+        bool started{};
+    };
+
+    /**
+     * Builds the tree from the derivation steps given by Syntax_parser. Tokens are located by the lexical parser
+     * scanning them while they're still buffered, as a streamed program's lines aren't kept after that.
+     */
+    class Builder : public Derivation_sink {
+    public:
+        Builder(Parse_tree &, const LexicalParser &);
+
+        void start(const std::vector<Symbol> &symbols, int start_symbol) override;
+
+        void expand(int non_terminal, int production, const int *begin, const int *end) override;
+
+        void pop(int non_terminal) override;
+
+        void match(int terminal, const Compact_token *token) override;
+
+        void discard(const Compact_token &token) override;
+
+    private:
+        Parse_tree &tree;
+        const LexicalParser &parser;
+        // Nodes which aren't expanded, popped or matched yet, the last one being the leftmost.
+        std::vector<Node *> pending;
+    };
+
+private:
+    Bump_arena<Node> nodes;
+    std::vector<Symbol> symbols;
+    Node *root{};
+    std::vector<Source_location> token_locations;
+
+    /**
+     * Allocates the children of the given node, one for each of the given symbol ids.
+     */
+    void expand(Node &node, std::int16_t production, const int *begin, const int *end);
+};
+
+
+#endif //COMPILER_PARSE_TREE_H
@@ -3,65 +3,128 @@
 //
 #include <iostream>
 #include <fstream>
+#include <set>
+#include <stdexcept>
 #include "ParsingTable.h"
 
 ParsingTable::ParsingTable(const std::unordered_map<Symbol, Rule> &rules,
                            const Syntax_Utils &syntaxUtils){
 
+    internSymbols(rules, syntaxUtils);
     for(const auto &[nonTerminal, productions] : rules)
         addRowToTable(nonTerminal, productions,syntaxUtils);
 
     writeToCSV("Table.csv");
 }
 
-bool ParsingTable::hasProduction(const Symbol &nonTerminal, const Symbol &terminal) const {
-    if(table.find(nonTerminal) != table.end()){
-        const std::unordered_map<Symbol,Production> &row = table.at(nonTerminal);
-        return row.find(terminal) != row.end();
+/**
+ * Gives ids to the terminals of every production and follow set, $ included, then to the non terminals. Both are
+ * sorted so that the ids don't depend on the order of the rules.
+ */
+void ParsingTable::internSymbols(const std::unordered_map<Symbol, Rule> &rules, const Syntax_Utils &syntaxUtils) {
+    std::set<Symbol> terminals{{"$", Symbol::Type::TERMINAL}}, nonTerminals;
+    for(const auto &[nonTerminal, productions] : rules){
+        nonTerminals.insert(nonTerminal);
+        syntaxUtils.follow_bits(nonTerminal).for_each([&](int terminal){
+            terminals.insert(syntaxUtils.get_terminal(terminal));
+        });
+        for(const auto &production : productions){
+            for(const auto &symbol : production){
+                if(symbol.type == Symbol::Type::TERMINAL)
+                    terminals.insert(symbol);
+                else if(symbol.type == Symbol::Type::NON_TERMINAL)
+                    nonTerminals.insert(symbol);
+            }
+        }
     }
-    return false;
+    symbols.assign(terminals.begin(), terminals.end());
+    terminal_count = (int) symbols.size();
+    symbols.insert(symbols.end(), nonTerminals.begin(), nonTerminals.end());
+    for(int id = 0; id < (int) symbols.size(); id++)
+        symbol_ids[symbols[id]] = id;
+    entries.assign(nonTerminals.size() * terminal_count, NO_PRODUCTION);
+}
+
+int ParsingTable::getId(const Symbol &symbol) const {
+    auto it = symbol_ids.find(symbol);
+    return it == symbol_ids.end() ? -1 : it->second;
+}
+
+bool ParsingTable::hasProduction(const Symbol &nonTerminal, const Symbol &terminal) const {
+    const int row = getId(nonTerminal), column = getId(terminal);
+    return row >= terminal_count && column >= 0 && column < terminal_count &&
+           getEntry(row, column) != NO_PRODUCTION;
+}
+
+Production ParsingTable::getProduction(const Symbol &nonTerminal, const Symbol &terminal) const {
+    if(!hasProduction(nonTerminal, terminal))
+        throw std::out_of_range("No production at entry of non_terminal = " + std::string(nonTerminal.name) +
+                                " and terminal = " + std::string(terminal.name) + ".");
+    return toProduction(getEntry(getId(nonTerminal), getId(terminal)));
 }
 
-const Production& ParsingTable::getProduction(const Symbol &nonTerminal, const Symbol &terminal) const {
-    return table.at(nonTerminal).at(terminal);
+/**
+ * Rebuilds the given production, or SYNC_ENTRY, from the ids of its symbols. Epsilon productions are {Є}.
+ */
+Production ParsingTable::toProduction(std::int16_t production) const {
+    if(production == SYNC_ENTRY)
+        return SYNC_PRODUCTION;
+    Production symbolsOfProduction;
+    for(const int *id = getProductionBegin(production); id != getProductionEnd(production); id++)
+        symbolsOfProduction.push_back(symbols[*id]);
+    if(symbolsOfProduction.empty())
+        symbolsOfProduction.push_back(eps_symbol);
+    return symbolsOfProduction;
 }
 
+std::int16_t ParsingTable::addProduction(const Production &production) {
+    if(production_begins.size() - 1 == INT16_MAX){
+        std::cerr << "More than " << INT16_MAX << " productions in the grammar.\n";
+        has_error = true;
+        return NO_PRODUCTION;
+    }
+    for(const auto &symbol : production){
+        if(symbol.type != Symbol::Type::EPSILON)
+            production_symbols.push_back(symbol_ids.at(symbol));
+    }
+    production_begins.push_back(production_symbols.size());
+    return (std::int16_t) (production_begins.size() - 2);
+}
 
 void ParsingTable::addRowToTable(const Symbol &nonTerminal, const std::vector<Production> &productions, const Syntax_Utils &syntaxUtils) {
 
     // store which production to use for the follow set of this non terminal
-    Production followProduction = {};
+    std::int16_t followProduction = NO_PRODUCTION;
+    Syntax_Utils::Terminal_bitset productionFirst(syntaxUtils.terminal_count());
     for(const auto &production : productions){
-        std::unordered_set<Symbol> productionFirst = syntaxUtils.first_of(production);
-        if(productionFirst.count(eps_symbol)){
-            if(followProduction.empty()){
-                followProduction = production;
+        const std::int16_t index = addProduction(production);
+        if(syntaxUtils.first_bits(production, productionFirst)){
+            if(followProduction == NO_PRODUCTION){
+                followProduction = index;
             }else{
                 std::cerr << "More than one production for non_terminal = " << nonTerminal.name << " evaluates to epsilon.\n";
                 has_error = true;
             }
-            productionFirst.erase(eps_symbol);
-        }
-        for(auto &terminal : productionFirst){
-            addProductionToRow(nonTerminal, terminal, production);
         }
+        productionFirst.for_each([&](int terminal){
+            addProductionToRow(nonTerminal, syntaxUtils.get_terminal(terminal), index);
+        });
     }
 
-    if(followProduction.empty())
-        followProduction = SYNC_PRODUCTION;
+    if(followProduction == NO_PRODUCTION)
+        followProduction = SYNC_ENTRY;
 
-    std::unordered_set<Symbol> nonTerminalFollow = syntaxUtils.follow_of(nonTerminal);
-    for(auto &terminal : nonTerminalFollow){
-        addProductionToRow(nonTerminal, terminal, followProduction);
-    }
+    syntaxUtils.follow_bits(nonTerminal).for_each([&](int terminal){
+        addProductionToRow(nonTerminal, syntaxUtils.get_terminal(terminal), followProduction);
+    });
 
 }
 
-void ParsingTable::addProductionToRow(const Symbol &nonTerminal, const Symbol &terminal, const Production &production) {
-    std::unordered_map<Symbol, Production> &row = table[nonTerminal];
-    if(row.find(terminal) == row.end()){
-        row[terminal] = production;
-    }else if(production != SYNC_PRODUCTION){
+void ParsingTable::addProductionToRow(const Symbol &nonTerminal, const Symbol &terminal, std::int16_t production) {
+    std::int16_t &entry = entries[(getId(nonTerminal) - terminal_count) * terminal_count + getId(terminal)];
+    if(entry == NO_PRODUCTION){
+        entry = production;
+    }else if(production != SYNC_ENTRY){
         std::cerr << "More than one production at entry of non_terminal = " << nonTerminal.name << " and terminal = " << terminal.name << " .\n";
         has_error = true;
     }
@@ -75,26 +138,21 @@ void ParsingTable::writeToCSV(const std::string &fileName) {
     std::ofstream tableFile;
     tableFile.open (fileName);
 
-    std::unordered_set<Symbol> terminals;
-    for(const auto &[symbol,row] : this->table){
-        for(const auto &[terminal,production] : row)
-            terminals.insert(terminal);
-    }
-
     std::vector<std::string> firstRow;
-    firstRow.reserve(terminals.size()+1);
+    firstRow.reserve(terminal_count+1);
     firstRow.push_back("");
-    for(const auto& symbol : terminals)
-        firstRow.push_back("'" + symbol.name + "'");
+    for(int terminal = 0; terminal < terminal_count; terminal++)
+        firstRow.push_back("'" + std::string(symbols[terminal].name) + "'");
     writeRowToCSV(firstRow,tableFile);
 
-    for(const auto &[nonTerminal,row] : this->table){
+    for(int nonTerminal = terminal_count; nonTerminal < (int) symbols.size(); nonTerminal++){
         std::vector<std::string> fileRow;
-        fileRow.reserve(terminals.size()+1);
-        fileRow.push_back(nonTerminal.name);
-        for(const auto& terminal : terminals){
-            if(hasProduction(nonTerminal,terminal))
-                fileRow.push_back(toString(getProduction(nonTerminal,terminal)));
+        fileRow.reserve(terminal_count+1);
+        fileRow.emplace_back(symbols[nonTerminal].name);
+        for(int terminal = 0; terminal < terminal_count; terminal++){
+            const std::int16_t production = getEntry(nonTerminal, terminal);
+            if(production != NO_PRODUCTION)
+                fileRow.push_back(toString(toProduction(production)));
             else
                 fileRow.push_back("");
         }
@@ -116,9 +174,9 @@ std::string ParsingTable::toString(const Production &production) {
     std::string text;
     for(const auto& symbol : production){
         if(symbol.type == Symbol::Type::TERMINAL)
-            text += ("'" + symbol.name + "' ");
+            text += ("'" + std::string(symbol.name) + "' ");
         else
-            text += (symbol.name + " ");
+            text += (std::string(symbol.name) + " ");
     }
     return text;
 }
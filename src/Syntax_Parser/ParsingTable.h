@@ -6,25 +6,83 @@
 #define COMPILER_PARSINGTABLE_H
 
 
+#include <cstdint>
 #include "Syntax_Utils.h"
 
+/**
+ * LL(1) parsing table. Terminals and non terminals are interned to dense ids, terminals taking the ids before
+ * non terminals, and every entry is the int16_t index of a production, so parsing only looks up arrays.
+ */
 class ParsingTable {
 public:
     ParsingTable(const std::unordered_map<Symbol, Rule> &rules,
                  const Syntax_Utils &syntaxUtils);
 
-    const Production& getProduction(const Symbol &nonTerminal, const Symbol &terminal) const;
+    // Entries which aren't indices of productions.
+    static constexpr std::int16_t NO_PRODUCTION = -1;
+    static constexpr std::int16_t SYNC_ENTRY = -2;
+
+    /**
+     * Production at the given entry, rebuilt from the ids of its symbols. Throws std::out_of_range if the entry
+     * is empty or the symbols aren't in the table.
+     */
+    Production getProduction(const Symbol &nonTerminal, const Symbol &terminal) const;
     bool hasProduction(const Symbol &nonTerminal, const Symbol &terminal) const;
     bool fail() const;
     void writeToCSV(const std::string &fileName);
 
+    /**
+     * Id of the given terminal or non terminal, or -1 if it's not in the grammar.
+     */
+    int getId(const Symbol &symbol) const;
+
+    const Symbol &getSymbol(int id) const {
+        return symbols[id];
+    }
+
+    int getSymbolCount() const {
+        return (int) symbols.size();
+    }
+
+    bool isTerminal(int id) const {
+        return id < terminal_count;
+    }
+
+    /**
+     * Production index, NO_PRODUCTION or SYNC_ENTRY at the given non terminal's row and terminal's column.
+     */
+    std::int16_t getEntry(int nonTerminalId, int terminalId) const {
+        return entries[(nonTerminalId - terminal_count) * terminal_count + terminalId];
+    }
+
+    /**
+     * Ids of the symbols of the given production, epsilon being left out.
+     */
+    const int *getProductionBegin(std::int16_t production) const {
+        return production_symbols.data() + production_begins[production];
+    }
+
+    const int *getProductionEnd(std::int16_t production) const {
+        return production_symbols.data() + production_begins[production + 1];
+    }
+
 private:
-    std::unordered_map<Symbol,std::unordered_map<Symbol,Production>> table;
+    std::unordered_map<Symbol, int> symbol_ids;
+    std::vector<Symbol> symbols;
+    int terminal_count{};
+    // Row major table with a row for every non terminal and a column for every terminal.
+    std::vector<std::int16_t> entries;
+    // Symbols of all productions one after the other, production i starting at production_begins[i].
+    std::vector<int> production_symbols;
+    std::vector<std::size_t> production_begins{0};
     bool has_error{};
 
+    void internSymbols(const std::unordered_map<Symbol, Rule> &rules, const Syntax_Utils &syntaxUtils);
+    std::int16_t addProduction(const Production &production);
     void addRowToTable(const Symbol &nonTerminal, const std::vector<Production> &productions,const Syntax_Utils &syntaxUtils);
-    void addProductionToRow(const Symbol &nonTerminal, const Symbol &terminal, const Production &production);
+    void addProductionToRow(const Symbol &nonTerminal, const Symbol &terminal, std::int16_t production);
     void writeRowToCSV(const std::vector<std::string> &row, std::ofstream &tableFile);
+    Production toProduction(std::int16_t production) const;
     std::string toString(const Production &production);
 };
 
@@ -188,7 +188,7 @@ std::vector<Symbol> Rules_builder::dfs(Node* node, std::unordered_map<Symbol, Ru
     Symbol new_lhs = origin_lhs;
     //The new Rule lhs is determined from the new_rules current size to have a unique lhs for each rule (A, A1, A2, ...)
     if(new_rules.size() >= 1)
-        new_lhs.name += std::to_string(new_rules.size());
+        new_lhs = {std::string(new_lhs.name) + std::to_string(new_rules.size()), Symbol::Type::NON_TERMINAL};
     new_rules.insert({new_lhs,Rule(new_lhs.name)});
 
 
@@ -259,7 +259,7 @@ void Rules_builder::eliminate_immediate_left_recursion(Rule &rule) {
         exit(-1);
     }
     rule.clear();
-    Symbol new_LHS = {rule.get_lhs().name+DASH, Symbol::Type::NON_TERMINAL};
+    Symbol new_LHS = {std::string(rule.get_lhs().name) + DASH, Symbol::Type::NON_TERMINAL};
     for (auto &prod : doesnt_start_with_LHS) {
         prod.push_back(new_LHS);
         rule.push_back(prod);
@@ -0,0 +1,44 @@
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "Symbol_table.h"
+
+struct Symbol_table::Storage {
+    std::mutex mutex;
+    // A deque never moves its strings, so the interned views stay valid.
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, Entry> entries;
+
+    Storage() {
+        names.emplace_back();
+        entries.emplace(names.back(), Entry{names.back(), 0, std::hash<std::string_view>()(names.back())});
+    }
+};
+
+/**
+ * Symbols are created while initializing globals such as eps_symbol, so the storage is created on first use.
+ */
+Symbol_table::Storage &Symbol_table::storage() {
+    static Storage storage;
+    return storage;
+}
+
+Symbol_table::Entry Symbol_table::intern(std::string_view name) {
+    Storage &table = storage();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto it = table.entries.find(name);
+    if (it == table.entries.end()) {
+        const std::string_view stored = table.names.emplace_back(name);
+        const Entry entry{stored, static_cast<std::uint32_t>(table.names.size() - 1),
+                          std::hash<std::string_view>()(stored)};
+        it = table.entries.emplace(stored, entry).first;
+    }
+    return it->second;
+}
+
+std::size_t Symbol_table::size() {
+    Storage &table = storage();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.names.size();
+}
@@ -0,0 +1,39 @@
+#ifndef COMPILER_SYMBOL_TABLE_H
+#define COMPILER_SYMBOL_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Interns the names of grammar symbols, so that symbols are compared and hashed by a 32-bit id and their names
+ * are only looked up for output. Names are never freed, so the interned views stay valid for the whole program.
+ * The empty name always has the id 0.
+ */
+class Symbol_table {
+public:
+    struct Entry {
+        std::string_view name;
+        std::uint32_t id;
+        // std::hash of the name, computed once.
+        std::size_t hash;
+    };
+
+    /**
+     * Returns the interned copy of the given name along with its id, the same name always getting the same id.
+     */
+    static Entry intern(std::string_view name);
+
+    /**
+     * Number of names interned so far.
+     */
+    static std::size_t size();
+
+private:
+    struct Storage;
+
+    static Storage &storage();
+};
+
+
+#endif //COMPILER_SYMBOL_TABLE_H
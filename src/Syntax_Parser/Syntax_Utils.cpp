@@ -3,30 +3,69 @@
 //
 
 #include "Syntax_Utils.h"
-#include <map>
+#include <set>
 #include <cassert>
 
 Syntax_Utils::Syntax_Utils(const std::unordered_map<Symbol, Rule> &rules,
                            const Symbol &start_symbol) {
 
+    this->intern_symbols(rules);
+
     // First, construct first table.
-    for (auto &[non_terminal, _] : rules) {
-        this->precompute_first(non_terminal, rules);
-        // initialize the follow sets
-        this->follow.insert({non_terminal, {}});
-    }
+    this->precompute_first(rules);
 
     // Then, construct Follow table.
-    assert(this->follow.find(start_symbol) != this->follow.end() && "Error: The rules have some undefined symbols, check it again.");
+    assert(this->non_terminal_ids.count(start_symbol) && "Error: The rules have some undefined symbols, check it again.");
     this->precompute_follow(rules, start_symbol);
 }
 
+/*
+ * Indexes the terminals, sorted by name along with $, and the non-terminals so that their sets are stored densely.
+ */
+void Syntax_Utils::intern_symbols(const std::unordered_map<Symbol, Rule> &rules) {
+    std::set<Symbol> terminal_set{{"$", Symbol::Type::TERMINAL}};
+    for (const auto &[non_terminal, rule] : rules) {
+        this->non_terminal_ids.emplace(non_terminal, (int) this->non_terminal_ids.size());
+        for (const Production &production : rule) {
+            for (const Symbol &symbol : production) {
+                if (symbol.type == Symbol::Type::TERMINAL) {
+                    terminal_set.insert(symbol);
+                }
+            }
+        }
+    }
+    this->terminals.assign(terminal_set.begin(), terminal_set.end());
+    for (int i = 0; i < (int) this->terminals.size(); i++) {
+        this->terminal_ids.emplace(this->terminals[i], i);
+    }
+    const std::size_t count = this->non_terminal_ids.size();
+    this->first.assign(count, Terminal_bitset(this->terminals.size()));
+    this->follow.assign(count, Terminal_bitset(this->terminals.size()));
+    this->nullable.assign(count, false);
+    this->empty_set = Terminal_bitset(this->terminals.size());
+}
+
+Syntax_Utils::Terminal_set Syntax_Utils::to_set(const Terminal_bitset &bits) const {
+    Terminal_set set;
+    bits.for_each([&](int terminal) {
+        set.insert(this->terminals[terminal]);
+    });
+    return set;
+}
+
 // Assumption it returns the name of the symbol when the symbol is not non-terminal.
 Syntax_Utils::First_set Syntax_Utils::first_of(const Symbol &symbol) const {
     if (symbol.type != Symbol::Type::NON_TERMINAL) {
         return {symbol};
     }
-    return Syntax_Utils::find(this->first, symbol);
+    if (!this->non_terminal_ids.count(symbol)) {
+        return {};
+    }
+    First_set symbol_first = to_set(first_bits(symbol));
+    if (is_nullable(symbol)) {
+        symbol_first.insert(eps_symbol);
+    }
+    return symbol_first;
 }
 
 Syntax_Utils::First_set Syntax_Utils::first_of(const Production& production) const {
@@ -44,65 +83,181 @@ Syntax_Utils::First_set Syntax_Utils::first_of(const Production& production) con
 
 Syntax_Utils::Follow_set Syntax_Utils::follow_of(const Symbol &symbol) const {
     assert(symbol.type == Symbol::Type::NON_TERMINAL && "Error: no follow-set for terminal/epsilon symbol");
-    return Syntax_Utils::find(this->follow, symbol);
+    return to_set(follow_bits(symbol));
 }
 
-Syntax_Utils::Terminal_set
-Syntax_Utils::find(const std::unordered_map<Symbol, Terminal_set> &set,const Symbol &non_terminal) {
-    auto it = set.find(non_terminal);
-    if (it == set.end()) {
-        return {};
-    }
-    return it->second;
+const Syntax_Utils::Terminal_bitset &Syntax_Utils::first_bits(const Symbol &symbol) const {
+    auto it = this->non_terminal_ids.find(symbol);
+    return it == this->non_terminal_ids.end() ? this->empty_set : this->first[it->second];
 }
 
-// Assumption: The rules CAN't have Left recursion, it may lead to undefined behavior if there's any.
-void Syntax_Utils::precompute_first(const Symbol &non_terminal,
-                                    const std::unordered_map<Symbol, Rule> &rules) {
+bool Syntax_Utils::is_nullable(const Symbol &symbol) const {
+    auto it = this->non_terminal_ids.find(symbol);
+    return it != this->non_terminal_ids.end() && this->nullable[it->second];
+}
 
-    // Checks if we have visited that non-terminal before.
-    if (this->first.find(non_terminal) != this->first.end()) {
-        return;
+bool Syntax_Utils::first_bits(const Production &production, Terminal_bitset &production_first) const {
+    production_first = Terminal_bitset(this->terminals.size());
+    for (const Symbol &symbol : production) {
+        if (symbol.type == Symbol::Type::TERMINAL) {
+            auto it = this->terminal_ids.find(symbol);
+            if (it != this->terminal_ids.end()) {
+                production_first.set(it->second);
+            }
+            return false;
+        }
+        if (symbol.type == Symbol::Type::NON_TERMINAL) {
+            production_first.merge(first_bits(symbol));
+            if (!is_nullable(symbol)) {
+                return false;
+            }
+        }
     }
-    this->first.insert({non_terminal, {eps_symbol}});
-
-    // Assumption: no errors of these kinds are allowed.
-    assert(rules.find(non_terminal) != rules.end() && "Error: The rules have some undefined symbols, check it again.");
-
-    // Keeps track if the first set of the current non-terminal so far.
-    First_set &current_first = this->first.at(non_terminal);
-
-    // As long as epsilon is false, the final first set shouldn't contain epsilon.
-    bool add_epsilon = false;
-    for (const Production &production : rules.at(non_terminal)) {
-
-        // epsilon flag relative to the current production.
-        // it's used also while iterating to decide if we should stop iterating if
-        // we encounter a terminal or a non-terminal with a free set without epsilon.
-        bool curr_epsilon = true;
-        for (int i = 0; i < production.size() && curr_epsilon; i++) {
-            const Symbol &symbol = production.at(i);
-            if (symbol.type == Symbol::Type::TERMINAL) {
-                current_first.insert(symbol);
-                curr_epsilon = false;
-            } else if (symbol.type == Symbol::Type::NON_TERMINAL) {
-                precompute_first(symbol, rules);
-                const First_set &temp = this->first.at(symbol);
-                if (temp.find(eps_symbol) == temp.end()) {
-                    curr_epsilon = false;
+    return true;
+}
+
+const Syntax_Utils::Terminal_bitset &Syntax_Utils::follow_bits(const Symbol &symbol) const {
+    auto it = this->non_terminal_ids.find(symbol);
+    return it == this->non_terminal_ids.end() ? this->empty_set : this->follow[it->second];
+}
+
+/*
+ *  Nullable non-terminals are found first: a production is nullable once all its non-terminals are, so every
+ *  production counts its non-terminals which aren't known to be nullable yet, and a worklist of the newly nullable
+ *  non-terminals decrements the counts of the productions they appear in.
+ *
+ *  Then FIRST(A) is the terminals directly starting A's productions, after nullable prefixes, along with FIRST(B)
+ *  of every edge A -> B where B starts a production of A the same way. Non-terminals of a strongly connected
+ *  component, e.g. left recursive ones, share the same FIRST set. Tarjan's algorithm finds the components
+ *  with successors first, so the FIRST of a component is complete once it's found.
+ */
+void Syntax_Utils::precompute_first(const std::unordered_map<Symbol, Rule> &rules) {
+    const int count = (int) this->non_terminal_ids.size();
+    auto id_of = [&](const Symbol &symbol) {
+        auto it = this->non_terminal_ids.find(symbol);
+        // Assumption: no errors of these kinds are allowed.
+        assert(it != this->non_terminal_ids.end() && "Error: The rules have some undefined symbols, check it again.");
+        return it->second;
+    };
+
+    // Productions with their left hand side and the number of their symbols which aren't known to be nullable.
+    std::vector<std::pair<int, int>> remaining;
+    std::vector<std::vector<int>> occurrences(count);
+    std::vector<int> worklist;
+    for (const auto &[non_terminal, rule] : rules) {
+        const int lhs = id_of(non_terminal);
+        for (const Production &production : rule) {
+            const int index = (int) remaining.size();
+            int symbols = 0;
+            for (const Symbol &symbol : production) {
+                if (symbol.type == Symbol::Type::TERMINAL) {
+                    // Never nullable.
+                    symbols = -1;
+                    break;
                 }
-                current_first.insert(temp.begin(), temp.end());
+                if (symbol.type == Symbol::Type::NON_TERMINAL) {
+                    symbols++;
+                    occurrences[id_of(symbol)].push_back(index);
+                }
+            }
+            remaining.emplace_back(lhs, symbols);
+            if (symbols == 0 && !this->nullable[lhs]) {
+                this->nullable[lhs] = true;
+                worklist.push_back(lhs);
+            }
+        }
+    }
+    while (!worklist.empty()) {
+        const int symbol = worklist.back();
+        worklist.pop_back();
+        for (int index : occurrences[symbol]) {
+            auto &[lhs, symbols] = remaining[index];
+            if (--symbols == 0 && !this->nullable[lhs]) {
+                this->nullable[lhs] = true;
+                worklist.push_back(lhs);
             }
-            else if (symbol.type == Symbol::Type::EPSILON) {
-                current_first.emplace(eps_symbol);
+        }
+    }
+
+    // Direct terminals and edges of every non-terminal.
+    std::vector<std::vector<int>> edges(count);
+    for (const auto &[non_terminal, rule] : rules) {
+        const int lhs = id_of(non_terminal);
+        for (const Production &production : rule) {
+            for (const Symbol &symbol : production) {
+                if (symbol.type == Symbol::Type::TERMINAL) {
+                    this->first[lhs].set(this->terminal_ids.at(symbol));
+                    break;
+                }
+                if (symbol.type == Symbol::Type::NON_TERMINAL) {
+                    const int next = id_of(symbol);
+                    if (next != lhs) {
+                        edges[lhs].push_back(next);
+                    }
+                    if (!this->nullable[next]) {
+                        break;
+                    }
+                }
             }
         }
-        add_epsilon |= curr_epsilon;
     }
 
-    // Makes sure if the epsilon should be in the first set or not.
-    if (!add_epsilon) {
-        current_first.erase(eps_symbol);
+    // Iterative Tarjan's algorithm, frames being the visited non-terminal and its next edge to follow.
+    constexpr int UNVISITED = -1;
+    std::vector<int> index(count, UNVISITED), low(count);
+    std::vector<char> on_stack(count, false);
+    std::vector<int> component;
+    std::vector<std::pair<int, std::size_t>> frames;
+    int next_index = 0;
+    for (int root = 0; root < count; root++) {
+        if (index[root] != UNVISITED) {
+            continue;
+        }
+        frames.emplace_back(root, 0);
+        while (!frames.empty()) {
+            auto &[symbol, edge] = frames.back();
+            if (edge == 0 && index[symbol] == UNVISITED) {
+                index[symbol] = low[symbol] = next_index++;
+                component.push_back(symbol);
+                on_stack[symbol] = true;
+            }
+            if (edge < edges[symbol].size()) {
+                const int next = edges[symbol][edge++];
+                if (index[next] == UNVISITED) {
+                    frames.emplace_back(next, 0);
+                } else if (on_stack[next]) {
+                    low[symbol] = std::min(low[symbol], index[next]);
+                }
+                continue;
+            }
+
+            const int finished = symbol;
+            frames.pop_back();
+            if (!frames.empty()) {
+                const int parent = frames.back().first;
+                low[parent] = std::min(low[parent], low[finished]);
+            }
+            if (low[finished] != index[finished]) {
+                continue;
+            }
+
+            // finished is the root of a component, which is on top of the stack.
+            const auto begin = std::find(component.rbegin(), component.rend(), finished).base() - 1;
+            Terminal_bitset component_first(this->terminals.size());
+            for (auto it = begin; it != component.end(); ++it) {
+                on_stack[*it] = false;
+                component_first.merge(this->first[*it]);
+                for (int next : edges[*it]) {
+                    // Successors in other components are already complete, while the ones in this component are
+                    // merged the same way.
+                    component_first.merge(this->first[next]);
+                }
+            }
+            for (auto it = begin; it != component.end(); ++it) {
+                this->first[*it] = component_first;
+            }
+            component.erase(begin, component.end());
+        }
     }
 }
 
@@ -110,7 +265,8 @@ void Syntax_Utils::precompute_follow(const std::unordered_map<Symbol, Rule> &rul
                                      const Symbol &start_symbol) {
     // it's just an assumption to use the dollar sign as an endmarker, following the reference convention.
     const std::string special_endmarker = "$";
-    this->follow.at(start_symbol).insert({special_endmarker, Symbol::Type::TERMINAL});
+    this->follow[this->non_terminal_ids.at(start_symbol)].set(
+            this->terminal_ids.at({special_endmarker, Symbol::Type::TERMINAL}));
     this->follow_calculate_by_first(rules);
     this->follow_calculate_by_follow(rules);
 }
@@ -124,28 +280,25 @@ void Syntax_Utils::precompute_follow(const std::unordered_map<Symbol, Rule> &rul
  */
 void Syntax_Utils::follow_calculate_by_first(const std::unordered_map<Symbol, Rule> &rules) {
 
+    Terminal_bitset curr_first(this->terminals.size());
     for (const auto &[_, rule] : rules) {
         for (const Production &production: rule) {
-            First_set curr_first;
+            curr_first.clear();
             for (int i = (int)production.size() - 1; i >= 0; i--) {
                 const Symbol &symbol = production.at(i);
                 if (symbol.type == Symbol::Type::NON_TERMINAL) {
+                    const int id = this->non_terminal_ids.at(symbol);
                     // Update the follow set with the first set of the suffix non-terminals.
-                    this->follow.at(symbol).insert(curr_first.begin(), curr_first.end());
-                    auto symbol_first = this->first.at(symbol);
-                    if (symbol_first.find(eps_symbol) == symbol_first.end()) {
+                    this->follow[id].merge(curr_first);
+                    if (!this->nullable[id]) {
                         // reset the first set of the suffix non-terminals.
                         curr_first.clear();
                     }
-                    else {
-                        symbol_first.erase(eps_symbol);
-                    }
-                    curr_first.insert(symbol_first.begin(), symbol_first.end());
-
+                    curr_first.merge(this->first[id]);
                 }
                 else if (symbol.type == Symbol::Type::TERMINAL){
                     curr_first.clear();
-                    curr_first.insert(symbol);
+                    curr_first.set(this->terminal_ids.at(symbol));
                 }
             }
         }
@@ -153,33 +306,41 @@ void Syntax_Utils::follow_calculate_by_first(const std::unordered_map<Symbol, Ru
 }
 
 /*
- *  It keeps applying the third rule until no change is observed in the follow sets.
- *  Changes are observed by keeping tracks of the size of each follow set and compare the old with the new one.
+ *  The third rule makes FOLLOW(A) a subset of FOLLOW(B), which is an edge from A to B. Follow sets are propagated
+ *  along these edges from a worklist of the non-terminals whose follow sets changed, until no change is observed.
  */
 void Syntax_Utils::follow_calculate_by_follow(const std::unordered_map<Symbol, Rule> &rules) {
 
-    bool updated;
-    do {
-        updated = false;
-        for (const auto &[lhs_non_terminal, rule] : rules) {
-            const auto &lhs_follow = this->follow.at(lhs_non_terminal);
-            for (const Production &production: rule) {
-                for (int i = (int)production.size() - 1; i >= 0 && production.at(i).type == Symbol::Type::NON_TERMINAL; i--) {
-                    const Symbol &symbol = production.at(i);
-                    const auto &symbol_first = this->first.at(symbol);
-                    auto &symbol_follow = this->follow.at(symbol);
-                    updated |= Syntax_Utils::insert_into(symbol_follow, lhs_follow);
-                    if (symbol_first.find(eps_symbol) == symbol_first.end()) {
-                        break;
-                    }
+    std::vector<std::vector<int>> edges(this->non_terminal_ids.size());
+    for (const auto &[lhs_non_terminal, rule] : rules) {
+        const int lhs = this->non_terminal_ids.at(lhs_non_terminal);
+        for (const Production &production: rule) {
+            for (int i = (int)production.size() - 1; i >= 0 && production.at(i).type == Symbol::Type::NON_TERMINAL; i--) {
+                const int symbol = this->non_terminal_ids.at(production.at(i));
+                if (symbol != lhs) {
+                    edges[lhs].push_back(symbol);
+                }
+                if (!this->nullable[symbol]) {
+                    break;
                 }
             }
         }
-    } while (updated);
-}
+    }
 
-bool Syntax_Utils::insert_into(Syntax_Utils::Terminal_set &dest, const Syntax_Utils::Terminal_set &src) {
-    int size = dest.size();
-    dest.insert(src.begin(), src.end());
-    return dest.size() != size;
+    std::vector<int> worklist((int) edges.size());
+    std::vector<char> in_worklist(edges.size(), true);
+    for (int i = 0; i < (int) edges.size(); i++) {
+        worklist[i] = i;
+    }
+    while (!worklist.empty()) {
+        const int lhs = worklist.back();
+        worklist.pop_back();
+        in_worklist[lhs] = false;
+        for (int symbol : edges[lhs]) {
+            if (this->follow[symbol].merge(this->follow[lhs]) && !in_worklist[symbol]) {
+                in_worklist[symbol] = true;
+                worklist.push_back(symbol);
+            }
+        }
+    }
 }
@@ -5,6 +5,8 @@
 #ifndef COMPILER_SYNTAX_UTILS_H
 #define COMPILER_SYNTAX_UTILS_H
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
 #include <unordered_set>
 #include <unordered_map>
@@ -20,6 +22,58 @@ public:
     using Follow_set = std::unordered_set<Symbol>;
     using Terminal_set = std::unordered_set<Symbol>;
 
+    /**
+     * Set of terminals stored as one bit per terminal, terminals being indexed by get_terminal.
+     */
+    class Terminal_bitset {
+    public:
+        explicit Terminal_bitset(std::size_t size = 0) : words((size + 63) / 64) {}
+
+        bool test(int terminal) const {
+            return words[terminal >> 6] >> (terminal & 63) & 1;
+        }
+
+        void set(int terminal) {
+            words[terminal >> 6] |= std::uint64_t{1} << (terminal & 63);
+        }
+
+        void reset(int terminal) {
+            words[terminal >> 6] &= ~(std::uint64_t{1} << (terminal & 63));
+        }
+
+        void clear() {
+            std::fill(words.begin(), words.end(), 0);
+        }
+
+        /**
+         * Adds all terminals of other to this set, which must be of the same size.
+         * @return true if any terminal was actually added, false otherwise.
+         */
+        bool merge(const Terminal_bitset &other) {
+            std::uint64_t added = 0;
+            for (std::size_t i = 0; i < words.size(); i++) {
+                added |= other.words[i] & ~words[i];
+                words[i] |= other.words[i];
+            }
+            return added != 0;
+        }
+
+        /**
+         * Calls f with the index of every terminal in the set, in increasing order.
+         */
+        template<typename F>
+        void for_each(F f) const {
+            for (std::size_t i = 0; i < words.size(); i++) {
+                for (std::uint64_t word = words[i]; word != 0; word &= word - 1) {
+                    f(static_cast<int>(i * 64 + __builtin_ctzll(word)));
+                }
+            }
+        }
+
+    private:
+        std::vector<std::uint64_t> words;
+    };
+
     /**
      * Constructing the Follow and First set using unordered_map of rules,
      * and the Start symbol.
@@ -40,9 +94,43 @@ public:
      */
     Follow_set follow_of(const Symbol &) const;
 
+    /**
+     * Same as first_of but without Є and without copies, Є being in FIRST(symbol) iff is_nullable(symbol).
+     * The symbol must be non-terminal.
+     */
+    const Terminal_bitset &first_bits(const Symbol &) const;
+
+    bool is_nullable(const Symbol &) const;
+
+    /**
+     * Stores FIRST(production) without Є in first.
+     * @return true if Є is in FIRST(production), false otherwise.
+     */
+    bool first_bits(const Production &, Terminal_bitset &first) const;
+
+    const Terminal_bitset &follow_bits(const Symbol &) const;
+
+    /**
+     * Terminals of the grammar along with $, indexed in the order of their names.
+     */
+    int terminal_count() const {
+        return (int) terminals.size();
+    }
+
+    const Symbol &get_terminal(int index) const {
+        return terminals[index];
+    }
+
 private:
-    std::unordered_map<Symbol, First_set> first;
-    std::unordered_map<Symbol, Follow_set> follow;
+    std::vector<Symbol> terminals;
+    std::unordered_map<Symbol, int> terminal_ids;
+    // Non-terminals are indexed in the order of the rules.
+    std::unordered_map<Symbol, int> non_terminal_ids;
+    std::vector<Terminal_bitset> first;
+    std::vector<char> nullable;
+    std::vector<Terminal_bitset> follow;
+    // FIRST and FOLLOW of symbols which are not in the rules.
+    Terminal_bitset empty_set;
 
     /**
      *To compute FIRST(X) for all grammar symbols X, it applies the following rules
@@ -56,8 +144,9 @@ private:
      *      nothing more to FIRST(X), but if Y1 -> Є, then we add FIRST(Y2), and
      *      So on.
      *  3. If X -> Є is a production, then add Є to FIRST(X).
+     *  It takes linear time without recursion and any grammar is allowed, left recursive ones included.
      */
-    void precompute_first(const Symbol &, const std::unordered_map<Symbol, Rule> &);
+    void precompute_first(const std::unordered_map<Symbol, Rule> &);
 
     /**
      *  To compute FOLLOW(A) for all non-terminals A, apply the following rules
@@ -81,13 +170,9 @@ private:
      */
     void follow_calculate_by_follow(const std::unordered_map<Symbol, Rule> &);
 
-    static Terminal_set find(const std::unordered_map<Symbol, Terminal_set>& ,const Symbol &);
+    void intern_symbols(const std::unordered_map<Symbol, Rule> &);
 
-    /**
-     * it insert all terminal Symbols from the src to dest,
-     * @return true if any symbol get actually inserted in the dest, false otherwise.
-     */
-    static bool insert_into(Syntax_Utils::Terminal_set &dest, const Syntax_Utils::Terminal_set &src);
+    Terminal_set to_set(const Terminal_bitset &) const;
 
 };
 
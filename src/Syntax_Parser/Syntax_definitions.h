@@ -1,4 +1,10 @@
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <utility>
+#include <vector>
+#include "Symbol_table.h"
 
 //
 // Created by hazem on 5/31/2021.
@@ -7,17 +13,38 @@
 #ifndef COMPILER_SYNTAX_ANALYZER_H
 #define COMPILER_SYNTAX_ANALYZER_H
 
+/**
+ * Handle of a grammar symbol, which is trivially copyable. The name is interned by Symbol_table, so symbols are
+ * compared by its id and hashed by its precomputed hash, only ordering them compares their names. Hashing the
+ * name rather than the id keeps hashed containers of symbols iterating, and so the grammar being transformed,
+ * the same way whatever order the names were interned in.
+ */
 struct Symbol {
     enum class Type {
         TERMINAL,
         NON_TERMINAL,
         EPSILON
     };
-    std::string name;
-    Type type;
+    std::string_view name;
+    std::uint32_t id{};
+    Type type{};
+    std::size_t hash{std::hash<std::string_view>()({})};
+
+    Symbol() = default;
+
+    Symbol(std::string_view name, Type type) : type(type) {
+        const Symbol_table::Entry entry = Symbol_table::intern(name);
+        this->name = entry.name;
+        this->id = entry.id;
+        this->hash = entry.hash;
+    }
 
     inline bool operator==(const Symbol &a) const {
-        return name == a.name && type == a.type;
+        return id == a.id && type == a.type;
+    }
+
+    inline bool operator!=(const Symbol &a) const {
+        return !(*this == a);
     }
 
     inline bool operator<(const Symbol &a) const {
@@ -33,7 +60,7 @@ namespace std
     {
         size_t
         operator()(const Symbol &symbol) const noexcept {
-            return hash<string>()(symbol.name);
+            return symbol.hash;
         }
     };
 }
@@ -41,16 +68,18 @@ namespace std
 // it's just assumption, can be changed later.
 const Symbol eps_symbol = {"#", Symbol::Type::EPSILON};
 
+static_assert(std::is_trivially_copyable<Symbol>::value, "Symbols are copied as plain handles.");
+
 using Production = std::vector<Symbol>;
 
 class Rule : public std::vector<Production> {
 public:
-    explicit Rule(std::string lhsName) {
-        lhs = {std::move(lhsName), Symbol::Type::NON_TERMINAL};
+    explicit Rule(std::string_view lhsName) {
+        lhs = {lhsName, Symbol::Type::NON_TERMINAL};
     }
 
-    explicit Rule(std::string lhsName, std::vector<Production> vec) : std::vector<Production>(std::move(vec)) {
-        lhs = {std::move(lhsName), Symbol::Type::NON_TERMINAL};
+    explicit Rule(std::string_view lhsName, std::vector<Production> vec) : std::vector<Production>(std::move(vec)) {
+        lhs = {lhsName, Symbol::Type::NON_TERMINAL};
     }
 
     const Symbol &get_lhs() const {
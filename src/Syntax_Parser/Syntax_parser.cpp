@@ -7,6 +7,7 @@
 #include <algorithm>
 #include "Syntax_parser.h"
 #include "Rules_builder.h"
+#include "Lexical_parser_wrapper.h"
 
 
 Syntax_parser::Syntax_parser(const std::unordered_map<Symbol, Rule> &rules, const Symbol &staring_symbol) : has_error(false) {
@@ -14,86 +15,82 @@ Syntax_parser::Syntax_parser(const std::unordered_map<Symbol, Rule> &rules, cons
 
     this->starting_symbol = staring_symbol;
     this->table = std::make_unique<ParsingTable>(rules, utils);
+    for (int id = 0; id < table->getSymbolCount(); id++) {
+        symbols.push_back(table->getSymbol(id));
+    }
 
     has_error = table->fail();
 }
 
 
-Syntax_parser::Behavior Syntax_parser::get_behavior(const Symbol &cur_sym, const Symbol &token_sym) const {
-    if (cur_sym.type == Symbol::Type::TERMINAL) {
+/**
+ * Terminals which aren't in the grammar have the id -1.
+ */
+Syntax_parser::Behavior Syntax_parser::get_behavior(int cur_sym, int token_sym) const {
+    if (table->isTerminal(cur_sym)) {
         return Behavior::MATCH_TERMINAL;
     }
-    if (!table->hasProduction(cur_sym, token_sym)) {
+    const std::int16_t production = token_sym < 0 ? ParsingTable::NO_PRODUCTION : table->getEntry(cur_sym, token_sym);
+    if (production == ParsingTable::NO_PRODUCTION) {
         return Behavior::NO_ENTRY;
     }
-    if (table->getProduction(cur_sym, token_sym) == SYNC_PRODUCTION) {
+    if (production == ParsingTable::SYNC_ENTRY) {
         return Behavior::SYNC_ENTRY;
     }
     return Behavior::ENTRY_EXISTS;
 }
 
-class Lexical_parser_wrapper {
-public:
-    explicit Lexical_parser_wrapper(LexicalParser &parser) : parser(parser) {
-    }
-
-    bool get_token(Token &token) {
-        if (parser.get_token(token)) {
-            return true;
-        }
-        if (state == State::RET_ENDING_SYMBOL) {
-            token = {"$", "$"};
-            return true;
-        }
-        return false;
+std::pair<std::vector<std::vector<Symbol>>, Syntax_parser::Status>
+Syntax_parser::parse(LexicalParser &parser) const {
+    Parse_tree tree;
+    const Status status = parse(parser, tree);
+    std::vector<std::vector<Symbol>> derivation;
+    Parse_tree::Leftmost_derivation forms(tree);
+    for (std::vector<Symbol> form; forms.next(form);) {
+        derivation.push_back(form);
     }
-
-    void next_token() {
-        parser.next_token();
-        // Add $ at the end for syntax parser if buffer is empty
-        if (Token temp; !get_token(temp) && state == State::RET_FROM_PARSER) {
-            state = State::RET_ENDING_SYMBOL;
-            return;
-        }
-        // Calling next_token after ending symbol.
-        if (state == State::RET_ENDING_SYMBOL) {
-            state = State::EMPTY_BUFFER;
-        }
+    if (derivation.empty()) {
+        // The starting symbol has no rules.
+        derivation.push_back({this->starting_symbol});
     }
+    return {derivation, status};
+}
 
-private:
-    LexicalParser &parser;
-    enum class State {
-        RET_FROM_PARSER, RET_ENDING_SYMBOL, EMPTY_BUFFER
-    };
-    State state = State::RET_FROM_PARSER;
-};
+Syntax_parser::Status Syntax_parser::parse(LexicalParser &parser, Parse_tree &tree) const {
+    tree = Parse_tree();
+    Parse_tree::Builder builder{tree, parser};
+    return parse(parser, builder);
+}
 
-std::pair<std::vector<std::vector<Symbol>>, Syntax_parser::Status>
-Syntax_parser::parse(LexicalParser &parser) const {
+Syntax_parser::Status Syntax_parser::parse(LexicalParser &parser, Derivation_sink &sink) const {
     Lexical_parser_wrapper tokenizer(parser);
-    std::vector<Symbol> matched_terminals;
-    std::vector<std::vector<Symbol>> derivation;
 
-    std::vector<Symbol> stk;
-    stk.push_back(Symbol{"$", Symbol::Type::TERMINAL});
-    stk.push_back(this->starting_symbol);
-    derivation.push_back({this->starting_symbol});
+    // Symbols are handled by their ids in the parsing table.
+    const int ending_id = table->getId({"$", Symbol::Type::TERMINAL});
+    std::vector<int> stk;
+    stk.push_back(ending_id);
+    stk.push_back(table->getId(this->starting_symbol));
+    if (stk.back() < 0) {
+        // The starting symbol has no rules.
+        return Status::NOT_MATCHED;
+    }
+    sink.start(symbols, stk.back());
 
     Status status = Status::ACCEPTED;
 
-    auto store_derivation = [&]() {
-        derivation.push_back(matched_terminals);
-        if (stk.size() > 1) {
-            derivation.back().insert(derivation.back().end(), stk.rbegin(), std::prev(stk.rend()));
-        }
-    };
+    // Terminal id and name of every token kind, found once so that tokens are never turned into strings.
+    std::vector<int> kind_ids;
+    std::vector<std::string> kind_names = parser.get_token_names();
+    kind_names.emplace_back("$");
+    for (const std::string &name : kind_names) {
+        kind_ids.push_back(table->getId({name, Symbol::Type::TERMINAL}));
+    }
 
-    Token curToken;
+    Compact_token curToken{};
     while (!stk.empty() && tokenizer.get_token(curToken)) {
 
-        const Symbol token_sym{curToken.regEXP, Symbol::Type::TERMINAL};
-        const Symbol &cur_sym = stk.back();
+        const int token_sym = kind_ids[curToken.kind];
+        const int cur_sym = stk.back();
 
         switch (get_behavior(cur_sym, token_sym)) {
             // Matches and pops two terminal symbols if they are equal
@@ -102,12 +99,19 @@ Syntax_parser::parse(LexicalParser &parser) const {
             // message saying that that unmatched terminal is inserted.
             case Behavior::MATCH_TERMINAL: {
                 stk.pop_back();
-                if (cur_sym.name == token_sym.name) {
-                    matched_terminals.push_back(cur_sym);
+                // $ at the bottom of the stack isn't part of the derivation.
+                const bool in_derivation = !stk.empty();
+                if (cur_sym == token_sym) {
+                    if (in_derivation) {
+                        sink.match(cur_sym, &curToken);
+                    }
                     tokenizer.next_token();
                 } else {
-                    std::cerr << "Error: missing " << cur_sym.name << ", inserted.\n";
-                    matched_terminals.push_back(cur_sym);
+                    if (in_derivation) {
+                        sink.match(cur_sym, nullptr);
+                    }
+                    std::cerr << tokenizer.error_at(curToken) << ": missing " << table->getSymbol(cur_sym).name
+                              << ", inserted.\n";
                     status = Status::ACCEPTED_WITH_ERRORS;
                 }
                 break;
@@ -115,40 +119,42 @@ Syntax_parser::parse(LexicalParser &parser) const {
                 // Pops non-terminal from the stack and pushes the matched production
                 // in reverse order to the stack.
             case Behavior::ENTRY_EXISTS: {
-                const Production &prod = table->getProduction(cur_sym, token_sym);
+                const std::int16_t production = table->getEntry(cur_sym, token_sym);
                 stk.pop_back();
-                std::for_each(prod.rbegin(), prod.rend(), [&](const Symbol &symbol) {
-                    if(symbol == eps_symbol) return;
-                    stk.push_back(symbol);
-                });
-                store_derivation();
+                stk.insert(stk.end(), std::make_reverse_iterator(table->getProductionEnd(production)),
+                           std::make_reverse_iterator(table->getProductionBegin(production)));
+                sink.expand(cur_sym, production, table->getProductionBegin(production),
+                            table->getProductionEnd(production));
                 break;
             }
                 // Error recovery: The parser will pop the non-terminal from the stack and
                 // continues from that state.
             case Behavior::SYNC_ENTRY: {
                 stk.pop_back();
-                std::cerr << "Error, Table[" << cur_sym.name << ", " << token_sym.name << "] = synch "
-                          << cur_sym.name << " has been popped.\n";
+                std::cerr << tokenizer.error_at(curToken) << ", Table[" << table->getSymbol(cur_sym).name << ", "
+                          << kind_names[curToken.kind] << "] = synch " << table->getSymbol(cur_sym).name
+                          << " has been popped.\n";
                 status = Status::ACCEPTED_WITH_ERRORS;
-                store_derivation();
+                sink.pop(cur_sym);
                 break;
             }
                 // Error recovery: For an empty entry, the input symbol is discarded.
             case Behavior::NO_ENTRY: {
+                // The lexeme is printed first as it may no longer be valid after moving to the next token.
+                std::cerr << tokenizer.error_at(curToken) << ": (illegal " << table->getSymbol(cur_sym).name
+                          << ") - discard " << kind_names[curToken.kind] << " \"" << curToken.lexeme << "\".\n";
+                sink.discard(curToken);
                 tokenizer.next_token();
-                std::cerr << "Error: (illegal " << cur_sym.name << ") - discard " << token_sym.name << " \""
-                          << curToken.match_string << "\".\n";
                 status = Status::ACCEPTED_WITH_ERRORS;
                 break;
             }
         }
     }
-    Token token;
+    Compact_token token{};
     if (stk.empty() != (!tokenizer.get_token(token))) {
         status = Status::NOT_MATCHED;
     }
-    return {derivation, status};
+    return status;
 }
 
 bool Syntax_parser::fail() const {
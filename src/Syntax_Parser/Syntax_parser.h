@@ -10,6 +10,8 @@
 #include <memory>
 #include "Syntax_definitions.h"
 #include "ParsingTable.h"
+#include "Parse_tree.h"
+#include "Derivation_sink.h"
 #include "../Parser/LexicalParser.h"
 
 class Syntax_parser {
@@ -22,20 +24,39 @@ public:
         NOT_MATCHED
     };
 
+    /**
+     * Parses the tokens of the given lexical parser.
+     * @return every sentential form of the leftmost derivation along with the status.
+     */
     std::pair<std::vector<std::vector<Symbol>>, Status> parse(LexicalParser &tokenizer) const;
 
+    /**
+     * Same as above but builds the parse tree instead, whose leftmost derivation can be made form by form with
+     * Parse_tree::Leftmost_derivation. The tree refers to the symbols by their ids, so it's empty if the starting
+     * symbol has no rules.
+     */
+    Status parse(LexicalParser &tokenizer, Parse_tree &tree) const;
+
+    /**
+     * Same as above but every step of the leftmost derivation is given to the sink as soon as it's made, so only
+     * the parser's stack is held in memory.
+     */
+    Status parse(LexicalParser &tokenizer, Derivation_sink &sink) const;
+
     bool fail() const;
 
 private:
     bool has_error{};
     Symbol starting_symbol;
     std::unique_ptr<ParsingTable> table;
+    // Symbol of every id of the table.
+    std::vector<Symbol> symbols;
 
     enum class Behavior {
         MATCH_TERMINAL, ENTRY_EXISTS, SYNC_ENTRY, NO_ENTRY
     };
 
-    Syntax_parser::Behavior get_behavior(const Symbol &cur_sym, const Symbol &token_sym) const;
+    Syntax_parser::Behavior get_behavior(int cur_sym, int token_sym) const;
 };
 
 